@@ -6,22 +6,114 @@
 #include <nvif/driver.h>
 #include <nvif/device.h>
 #include <nvif/class.h>
+#include <nvif/if0001.h>
 
 #include "util.h"
 
+struct time_attr {
+	struct nvif_control_time_attr_v0 v0;
+	s64 total;
+};
+
+static int
+time_attr_cmp(const void *a, const void *b)
+{
+	const struct time_attr *x = a, *y = b;
+	if (x->total != y->total)
+		return x->total < y->total ? 1 : -1;
+	return strcmp(x->v0.name, y->v0.name);
+}
+
+static void
+time_show(struct nvif_device *device, bool json)
+{
+	struct nvif_control_time_info_v0 info = {};
+	struct time_attr attr[64];
+	struct nvif_object ctrl;
+	int ret, i, nr = 0;
+
+	ret = nvif_object_init(&device->object, 0, NVIF_CLASS_CONTROL,
+			       NULL, 0, &ctrl);
+	if (ret) {
+		fprintf(stderr, "control object unavailable, %d\n", ret);
+		return;
+	}
+
+	ret = nvif_mthd(&ctrl, NVIF_CONTROL_TIME_INFO, &info, sizeof(info));
+	if (ret)
+		goto done;
+
+	do {
+		struct time_attr *a = &attr[nr];
+		memset(a, 0x00, sizeof(*a));
+		a->v0.index = nr ? attr[nr - 1].v0.index : 0;
+		ret = nvif_mthd(&ctrl, NVIF_CONTROL_TIME_ATTR,
+				&a->v0, sizeof(a->v0));
+		if (ret)
+			break;
+		/* init already includes the first-time oneinit. */
+		a->total = a->v0.preinit + a->v0.init;
+	} while (attr[nr++].v0.index && nr < ARRAY_SIZE(attr));
+
+	qsort(attr, nr, sizeof(attr[0]), time_attr_cmp);
+
+	if (json) {
+		printf("{\n");
+		printf("\t\"device\": { \"preinit\": %lld, \"post\": %lld, "
+		       "\"init\": %lld, \"fini\": %lld, \"suspend\": %lld },\n",
+		       info.preinit, info.post, info.init,
+		       info.fini, info.suspend);
+		printf("\t\"subdev\": [\n");
+		for (i = 0; i < nr; i++) {
+			printf("\t\t{ \"name\": \"%s\", \"preinit\": %lld, "
+			       "\"oneinit\": %lld, \"init\": %lld, "
+			       "\"fini\": %lld, \"suspend\": %lld }%s\n",
+			       attr[i].v0.name, attr[i].v0.preinit,
+			       attr[i].v0.oneinit, attr[i].v0.init,
+			       attr[i].v0.fini, attr[i].v0.suspend,
+			       (i + 1 < nr) ? "," : "");
+		}
+		printf("\t]\n");
+		printf("}\n");
+	} else {
+		printf("device: preinit %lldus (post %lldus) init %lldus "
+		       "fini %lldus suspend %lldus\n",
+		       info.preinit, info.post, info.init,
+		       info.fini, info.suspend);
+		printf("%-10s %10s %10s %10s %10s %10s\n", "subdev",
+		       "preinit", "oneinit", "init", "fini", "suspend");
+		for (i = 0; i < nr; i++) {
+			printf("%-10s %10lld %10lld %10lld %10lld %10lld\n",
+			       attr[i].v0.name, attr[i].v0.preinit,
+			       attr[i].v0.oneinit, attr[i].v0.init,
+			       attr[i].v0.fini, attr[i].v0.suspend);
+		}
+	}
+
+done:
+	nvif_object_fini(&ctrl);
+}
+
 int
 main(int argc, char **argv)
 {
 	struct nvif_client client;
 	struct nvif_device device;
 	bool suspend = false, wait = false;
+	int time = 0;
 	int ret, c;
 
-	while ((c = getopt(argc, argv, "sw"U_GETOPT)) != -1) {
+	while ((c = getopt(argc, argv, "jstw"U_GETOPT)) != -1) {
 		switch (c) {
+		case 'j':
+			time = 2;
+			break;
 		case 's':
 			suspend = true;
 			break;
+		case 't':
+			time = 1;
+			break;
 		case 'w':
 			wait = true;
 			break;
@@ -42,6 +134,9 @@ main(int argc, char **argv)
 		nvif_client_resume(&client);
 	}
 
+	if (time)
+		time_show(&device, time == 2);
+
 	while (wait && (c = getchar()) == EOF) {
 		sched_yield();
 	}
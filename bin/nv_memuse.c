@@ -0,0 +1,158 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/class.h>
+#include <nvif/mem.h>
+#include <nvif/mmu.h>
+#include <nvif/vmm.h>
+#include <nvif/if0000.h>
+
+#include "util.h"
+
+static int
+print_memory(struct nvif_client *client, const char *when)
+{
+	struct nvif_client_memory_v0 args = {};
+	int ret;
+
+	ret = nvif_object_mthd(&client->object, NVIF_CLIENT_V0_MEMORY,
+			       &args, sizeof(args));
+	if (ret)
+		return ret;
+
+	printf("%-8s vram %16llu host %16llu pgt %16llu chan %16llu\n",
+	       when, args.vram, args.host, args.pgt, args.chan);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct nvif_mclass
+	mems[] = {
+		{ NVIF_CLASS_MEM_GF100, -1 },
+		{ NVIF_CLASS_MEM_NV50 , -1 },
+		{ NVIF_CLASS_MEM_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	mmus[] = {
+		{ NVIF_CLASS_MMU_GF100, -1 },
+		{ NVIF_CLASS_MMU_NV50 , -1 },
+		{ NVIF_CLASS_MMU_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	vmms[] = {
+		{ NVIF_CLASS_VMM_GP100, -1 },
+		{ NVIF_CLASS_VMM_GM200, -1 },
+		{ NVIF_CLASS_VMM_GF100, -1 },
+		{ NVIF_CLASS_VMM_NV50 , -1 },
+		{ NVIF_CLASS_VMM_NV04 , -1 },
+		{}
+	};
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nvif_mmu mmu;
+	struct nvif_vmm vmm;
+	struct nvif_vma *vma = NULL;
+	struct nvif_mem *mem = NULL;
+	u64 size = 0x100000;
+	int mclass, type, count = 1, page = 12, i;
+	bool map = false, vram = false;
+	int ret, c;
+
+	while ((c = getopt(argc, argv, "mn:p:s:v"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'm': map = true; break;
+		case 'n': count = strtol(optarg, NULL, 0); break;
+		case 'p': page = strtol(optarg, NULL, 0); break;
+		case 's': size = strtoull(optarg, NULL, 0); break;
+		case 'v': vram = true; break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	if (count < 1)
+		return 1;
+
+	ret = u_device("lib", argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		return ret;
+
+	if ((ret = nvif_mclass(&device.object, mmus)) < 0 ||
+	    (ret = nvif_mmu_init(&device.object, mmus[ret].oclass, &mmu)))
+		goto done_device;
+
+	if ((ret = nvif_mclass(&mmu.object, vmms)) < 0 ||
+	    (ret = nvif_vmm_init(&mmu, vmms[ret].oclass, PAGE_SIZE, 0,
+				 NULL, 0, &vmm)))
+		goto done_mmu;
+
+	if ((mclass = nvif_mclass(&mmu.object, mems)) < 0 ||
+	    (type = nvif_mmu_type(&mmu, vram ? NVIF_MEM_VRAM :
+						NVIF_MEM_HOST)) < 0) {
+		ret = -ENODEV;
+		goto done_vmm;
+	}
+
+	mem = calloc(count, sizeof(*mem));
+	vma = calloc(count, sizeof(*vma));
+	if (!mem || !vma) {
+		ret = -ENOMEM;
+		goto done_mem;
+	}
+
+	if ((ret = print_memory(&client, "before")))
+		goto done_mem;
+
+	for (i = 0; i < count; i++) {
+		ret = nvif_mem_init_type(&mmu, mems[mclass].oclass, type,
+					 vram ? page : PAGE_SHIFT, size,
+					 NULL, 0, &mem[i]);
+		if (ret)
+			goto done_mem;
+
+		if (map) {
+			ret = nvif_vmm_get(&vmm, LAZY, false, page, 0,
+					   size, &vma[i]);
+			if (ret)
+				goto done_mem;
+
+			ret = nvif_vmm_map(&vmm, vma[i].addr, size, NULL, 0,
+					   &mem[i], 0);
+			if (ret)
+				goto done_mem;
+		}
+	}
+
+	if ((ret = print_memory(&client, "alloc")))
+		goto done_mem;
+
+done_mem:
+	for (i = 0; mem && vma && i < count; i++) {
+		nvif_vmm_put(&vmm, &vma[i]);
+		nvif_mem_fini(&mem[i]);
+	}
+	free(vma);
+	free(mem);
+	if (!ret)
+		ret = print_memory(&client, "free");
+done_vmm:
+	nvif_vmm_fini(&vmm);
+done_mmu:
+	nvif_mmu_fini(&mmu);
+done_device:
+	if (ret)
+		printf("%s\n", strerror(-ret));
+	nvif_device_fini(&device);
+	nvif_client_fini(&client);
+	return ret;
+}
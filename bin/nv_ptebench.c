@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/class.h>
+#include <nvif/mem.h>
+#include <nvif/mmu.h>
+#include <nvif/vmm.h>
+
+#include "util.h"
+
+/* Times repeated map/unmap of a single allocation into a region whose page
+ * tables already exist, so what's measured is (almost entirely) the cost of
+ * writing PTEs through the nvkm_memory accessors.
+ */
+static u64
+time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct nvif_mclass
+	mems[] = {
+		{ NVIF_CLASS_MEM_GF100, -1 },
+		{ NVIF_CLASS_MEM_NV50 , -1 },
+		{ NVIF_CLASS_MEM_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	mmus[] = {
+		{ NVIF_CLASS_MMU_GF100, -1 },
+		{ NVIF_CLASS_MMU_NV50 , -1 },
+		{ NVIF_CLASS_MMU_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	vmms[] = {
+		{ NVIF_CLASS_VMM_GP100, -1 },
+		{ NVIF_CLASS_VMM_GM200, -1 },
+		{ NVIF_CLASS_VMM_GF100, -1 },
+		{ NVIF_CLASS_VMM_NV50 , -1 },
+		{ NVIF_CLASS_VMM_NV04 , -1 },
+		{}
+	};
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nvif_mmu mmu;
+	struct nvif_vmm vmm;
+	struct nvif_vma vma = {};
+	struct nvif_mem mem = {};
+	u64 size = 0x10000000, map_ns = 0, unmap_ns = 0, ptes, t;
+	int mclass, type, count = 16, page = 12, i;
+	bool sparse = false, vram = false;
+	int ret, c;
+
+	while ((c = getopt(argc, argv, "n:p:s:Sv"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'n': count = strtol(optarg, NULL, 0); break;
+		case 'p': page = strtol(optarg, NULL, 0); break;
+		case 's': size = strtoull(optarg, NULL, 0); break;
+		case 'S': sparse = true; break;
+		case 'v': vram = true; break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	if (count < 1 || !size || (size & ((1ULL << page) - 1)))
+		return 1;
+
+	ret = u_device("lib", argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		return ret;
+
+	if ((ret = nvif_mclass(&device.object, mmus)) < 0 ||
+	    (ret = nvif_mmu_init(&device.object, mmus[ret].oclass, &mmu)))
+		goto done_device;
+
+	if ((ret = nvif_mclass(&mmu.object, vmms)) < 0 ||
+	    (ret = nvif_vmm_init(&mmu, vmms[ret].oclass, PAGE_SIZE, 0,
+				 NULL, 0, &vmm)))
+		goto done_mmu;
+
+	if ((mclass = nvif_mclass(&mmu.object, mems)) < 0 ||
+	    (type = nvif_mmu_type(&mmu, vram ? NVIF_MEM_VRAM :
+						NVIF_MEM_HOST)) < 0) {
+		ret = -ENODEV;
+		goto done_vmm;
+	}
+
+	ret = nvif_mem_init_type(&mmu, mems[mclass].oclass, type,
+				 vram ? page : PAGE_SHIFT, size,
+				 NULL, 0, &mem);
+	if (ret)
+		goto done_vmm;
+
+	/* Page tables are allocated up-front, and not freed on unmap. */
+	ret = nvif_vmm_get(&vmm, PTES, sparse, page, 0, size, &vma);
+	if (ret)
+		goto done_mem;
+
+	for (i = 0; i < count; i++) {
+		t = time_ns();
+		ret = nvif_vmm_map(&vmm, vma.addr, size, NULL, 0, &mem, 0);
+		if (ret)
+			goto done_vma;
+		map_ns += time_ns() - t;
+
+		t = time_ns();
+		ret = nvif_vmm_unmap(&vmm, vma.addr);
+		if (ret)
+			goto done_vma;
+		unmap_ns += time_ns() - t;
+	}
+
+	ptes = (size >> page) * count;
+	printf("%d iterations, %llu PTEs each\n", count, size >> page);
+	printf("map  : %12llu ns/iter %8llu ps/PTE\n",
+	       map_ns / count, map_ns * 1000 / ptes);
+	printf("unmap: %12llu ns/iter %8llu ps/PTE (%s)\n",
+	       unmap_ns / count, unmap_ns * 1000 / ptes,
+	       sparse ? "sparse" : "invalid");
+
+done_vma:
+	nvif_vmm_put(&vmm, &vma);
+done_mem:
+	nvif_mem_fini(&mem);
+done_vmm:
+	nvif_vmm_fini(&vmm);
+done_mmu:
+	nvif_mmu_fini(&mmu);
+done_device:
+	if (ret)
+		printf("%s\n", strerror(-ret));
+	nvif_device_fini(&device);
+	nvif_client_fini(&client);
+	return ret;
+}
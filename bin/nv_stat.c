@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/class.h>
+#include <nvif/if0001.h>
+
+#include "util.h"
+
+/* Dumps the statistics counters that subdevs report through the control
+ * object, as "subdev counter value" lines, or as JSON with -j.
+ */
+int
+main(int argc, char **argv)
+{
+	struct nvif_control_stat_attr_v0 args = {};
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nvif_object ctrl;
+	bool json = false;
+	int ret, c, nr = 0;
+
+	while ((c = getopt(argc, argv, "j"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'j':
+			json = true;
+			break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	ret = u_device(NULL, argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		return ret;
+
+	ret = nvif_object_init(&device.object, 0, NVIF_CLASS_CONTROL,
+			       NULL, 0, &ctrl);
+	if (ret) {
+		fprintf(stderr, "control object unavailable, %d\n", ret);
+		goto done_device;
+	}
+
+	if (json)
+		printf("[\n");
+
+	do {
+		ret = nvif_mthd(&ctrl, NVIF_CONTROL_STAT_ATTR,
+				&args, sizeof(args));
+		if (ret) {
+			/* No subdev reports any counters. */
+			if (ret == -ENODEV && !nr)
+				ret = 0;
+			break;
+		}
+
+		if (json) {
+			printf("%s\t{ \"subdev\": \"%s\", \"name\": \"%s\", "
+			       "\"value\": %llu }", nr ? ",\n" : "",
+			       args.owner, args.name, args.value);
+		} else {
+			printf("%-10s %-32s %20llu\n",
+			       args.owner, args.name, args.value);
+		}
+		nr++;
+	} while (args.subdev || args.index);
+
+	if (json)
+		printf("%s]\n", nr ? "\n" : "");
+
+	nvif_object_fini(&ctrl);
+done_device:
+	nvif_device_fini(&device);
+	nvif_client_fini(&client);
+	return ret;
+}
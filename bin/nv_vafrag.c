@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/class.h>
+#include <nvif/mmu.h>
+#include <nvif/vmm.h>
+
+#include "util.h"
+
+/* Fragments a VMM's address-space with a mix of differently-sized and
+ * aligned allocations, then times allocation of further ones.
+ *
+ * The "churn" phase repeatedly frees or allocates a random slot, the
+ * "holes" phase leaves every other small block free and times 64KiB
+ * allocations aligned to 64KiB and 2MiB, which must skip over holes
+ * that are large enough but can't satisfy the alignment.
+ */
+static u64
+time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Mostly small 4KiB-aligned buffers, with some 64KiB, 128KiB and 2MiB
+ * aligned ones, and 16KiB alignment which isn't a page size.
+ */
+static void
+vafrag_req(u8 *align, u64 *size)
+{
+	int r = rand() % 100;
+	if (r < 60) { *align = 12; *size = (1 + rand() % 16) << 12; } else
+	if (r < 75) { *align = 14; *size = (1 + rand() % 16) << 12; } else
+	if (r < 88) { *align = 16; *size = (1 + rand() % 16) << 16; } else
+	if (r < 96) { *align = 17; *size = (1 + rand() % 8) << 17; } else
+		    { *align = 21; *size = (1 + rand() % 4) << 21; }
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct nvif_mclass
+	mmus[] = {
+		{ NVIF_CLASS_MMU_GF100, -1 },
+		{ NVIF_CLASS_MMU_NV50 , -1 },
+		{ NVIF_CLASS_MMU_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	vmms[] = {
+		{ NVIF_CLASS_VMM_GP100, -1 },
+		{ NVIF_CLASS_VMM_GM200, -1 },
+		{ NVIF_CLASS_VMM_GF100, -1 },
+		{ NVIF_CLASS_VMM_NV50 , -1 },
+		{ NVIF_CLASS_VMM_NV04 , -1 },
+		{}
+	};
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nvif_mmu mmu;
+	struct nvif_vmm vmm;
+	struct nvif_vma *slot, vma;
+	u64 get_ns[32] = {}, put_ns = 0, size, t;
+	int get_nr[32] = {}, put_nr = 0, fail = 0;
+	int count = 16384, rounds = 100000, seed = 1, i, s;
+	int ret, c;
+	u8 align;
+
+	while ((c = getopt(argc, argv, "n:r:s:"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'n': count = strtol(optarg, NULL, 0); break;
+		case 'r': rounds = strtol(optarg, NULL, 0); break;
+		case 's': seed = strtol(optarg, NULL, 0); break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	if (count < 2 || rounds < 1)
+		return 1;
+
+	if (!(slot = calloc(count, sizeof(*slot))))
+		return -ENOMEM;
+	srand(seed);
+
+	ret = u_device("lib", argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		goto done_slot;
+
+	if ((ret = nvif_mclass(&device.object, mmus)) < 0 ||
+	    (ret = nvif_mmu_init(&device.object, mmus[ret].oclass, &mmu)))
+		goto done_device;
+
+	if ((ret = nvif_mclass(&mmu.object, vmms)) < 0 ||
+	    (ret = nvif_vmm_init(&mmu, vmms[ret].oclass, PAGE_SIZE, 0,
+				 NULL, 0, &vmm)))
+		goto done_mmu;
+
+	/* Churn: fill every slot, free half, then randomly free/allocate. */
+	for (i = 0; i < count; i++) {
+		vafrag_req(&align, &size);
+		nvif_vmm_get(&vmm, ADDR, false, 12, align, size, &slot[i]);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (rand() & 1)
+			nvif_vmm_put(&vmm, &slot[i]);
+	}
+
+	for (i = 0; i < rounds; i++) {
+		s = rand() % count;
+		if (slot[s].size) {
+			t = time_ns();
+			nvif_vmm_put(&vmm, &slot[s]);
+			put_ns += time_ns() - t;
+			put_nr++;
+		} else {
+			vafrag_req(&align, &size);
+			t = time_ns();
+			if (nvif_vmm_get(&vmm, ADDR, false, 12, align, size,
+					 &slot[s]))
+				fail++;
+			get_ns[align] += time_ns() - t;
+			get_nr[align]++;
+		}
+	}
+
+	printf("churn: %d slots, %d rounds, %d failed\n", count, rounds, fail);
+	for (i = 0; i < ARRAY_SIZE(get_ns); i++) {
+		if (get_nr[i]) {
+			printf("  get %3dKiB-aligned: %8llu ns\n",
+			       1 << (i - 10), get_ns[i] / get_nr[i]);
+		}
+	}
+	if (put_nr)
+		printf("  put              : %8llu ns\n", put_ns / put_nr);
+
+	/* Holes: 64KiB..1MiB blocks, with every other one freed. */
+	for (i = 0; i < count; i++)
+		nvif_vmm_put(&vmm, &slot[i]);
+	for (i = 0; i < count; i++)
+		nvif_vmm_get(&vmm, ADDR, false, 12, 12,
+			     (16 + rand() % 241) << 12, &slot[i]);
+	for (i = 0; i < count; i += 2)
+		nvif_vmm_put(&vmm, &slot[i]);
+
+	memset(get_ns, 0, sizeof(get_ns));
+	memset(get_nr, 0, sizeof(get_nr));
+	fail = 0;
+
+	for (i = 0; i < rounds; i++) {
+		align = (i & 1) ? 21 : 16;
+		t = time_ns();
+		ret = nvif_vmm_get(&vmm, ADDR, false, 12, align, 0x10000, &vma);
+		get_ns[align] += time_ns() - t;
+		get_nr[align]++;
+		if (ret)
+			fail++;
+		else
+			nvif_vmm_put(&vmm, &vma);
+	}
+
+	printf("holes: %d holes, %d rounds, %d failed\n",
+	       (count + 1) / 2, rounds, fail);
+	printf("  get 64KiB-aligned: %8llu ns\n", get_ns[16] / get_nr[16]);
+	printf("  get  2MiB-aligned: %8llu ns\n", get_ns[21] / get_nr[21]);
+	ret = 0;
+
+	for (i = 0; i < count; i++)
+		nvif_vmm_put(&vmm, &slot[i]);
+	nvif_vmm_fini(&vmm);
+done_mmu:
+	nvif_mmu_fini(&mmu);
+done_device:
+	if (ret)
+		printf("%s\n", strerror(-ret));
+	nvif_device_fini(&device);
+	nvif_client_fini(&client);
+done_slot:
+	free(slot);
+	return ret;
+}
@@ -0,0 +1,200 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/class.h>
+#include <nvif/mem.h>
+#include <nvif/mmu.h>
+#include <nvif/vmm.h>
+#include <nvif/if000c.h>
+
+#include "util.h"
+
+static const char *
+level_type(u8 type)
+{
+	switch (type) {
+	case NVIF_VMM_FOOTPRINT_LEVEL_V0_PGD: return "PGD";
+	case NVIF_VMM_FOOTPRINT_LEVEL_V0_PGT: return "PGT";
+	case NVIF_VMM_FOOTPRINT_LEVEL_V0_SPT: return "SPT";
+	case NVIF_VMM_FOOTPRINT_LEVEL_V0_LPT: return "LPT";
+	default:
+		return "???";
+	}
+}
+
+static int
+print_footprint(struct nvif_vmm *vmm)
+{
+	struct nvif_vmm_footprint_v0 args;
+	u64 bytes = 0, swbytes = 0;
+	int ret, i;
+
+	if ((ret = nvif_vmm_footprint(vmm, &args)))
+		return ret;
+
+	printf("lvl type bits   tables    hwpts   sparse "
+	       "            refs            bytes          swbytes\n");
+	for (i = 0; i < args.level_nr; i++) {
+		struct nvif_vmm_footprint_level_v0 *level = &args.level[i];
+		printf("%3d  %s %4d %8u %8u %8u %16llu %16llu %16llu\n",
+		       i, level_type(level->type), level->bits,
+		       level->tables, level->hwpts, level->sparse,
+		       level->refs, level->bytes, level->swbytes);
+		bytes += level->bytes;
+		swbytes += level->swbytes;
+	}
+	printf("total: %llu bytes of page tables, %llu bytes of tracking\n",
+	       bytes, swbytes);
+
+	for (i = 0; i < args.page_nr; i++) {
+		printf("page %2d: %016llx bytes mapped\n",
+		       args.page[i].shift, args.page[i].mapped);
+	}
+
+	printf("largest mapped  : %016llx-%016llx\n", args.mapped_addr,
+	       args.mapped_addr + args.mapped_size);
+	printf("largest unmapped: %016llx-%016llx\n", args.unmapped_addr,
+	       args.unmapped_addr + args.unmapped_size);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct nvif_mclass
+	mems[] = {
+		{ NVIF_CLASS_MEM_GF100, -1 },
+		{ NVIF_CLASS_MEM_NV50 , -1 },
+		{ NVIF_CLASS_MEM_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	mmus[] = {
+		{ NVIF_CLASS_MMU_GF100, -1 },
+		{ NVIF_CLASS_MMU_NV50 , -1 },
+		{ NVIF_CLASS_MMU_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	vmms[] = {
+		{ NVIF_CLASS_VMM_GP100, -1 },
+		{ NVIF_CLASS_VMM_GM200, -1 },
+		{ NVIF_CLASS_VMM_GF100, -1 },
+		{ NVIF_CLASS_VMM_NV50 , -1 },
+		{ NVIF_CLASS_VMM_NV04 , -1 },
+		{}
+	};
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nvif_mmu mmu;
+	struct nvif_vmm vmm;
+	struct nvif_vma sparse = {}, *vma = NULL;
+	struct nvif_mem *mem = NULL;
+	u64 ssize = 0, msize = 0, addr;
+	int mclass, type, count = 1, page = 12, i;
+	bool vram = false;
+	int ret, c;
+
+	while ((c = getopt(argc, argv, "m:n:p:s:v"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'm': msize = strtoull(optarg, NULL, 0); break;
+		case 'n': count = strtol(optarg, NULL, 0); break;
+		case 'p': page = strtol(optarg, NULL, 0); break;
+		case 's': ssize = strtoull(optarg, NULL, 0); break;
+		case 'v': vram = true; break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	if (count < 1)
+		return 1;
+
+	ret = u_device("lib", argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		return ret;
+
+	if ((ret = nvif_mclass(&device.object, mmus)) < 0 ||
+	    (ret = nvif_mmu_init(&device.object, mmus[ret].oclass, &mmu)))
+		goto done_device;
+
+	if ((ret = nvif_mclass(&mmu.object, vmms)) < 0 ||
+	    (ret = nvif_vmm_init(&mmu, vmms[ret].oclass, PAGE_SIZE, 0,
+				 NULL, 0, &vmm)))
+		goto done_mmu;
+
+	/* Reserve a sparse region, which mappings are placed inside of. */
+	if (ssize) {
+		ret = nvif_vmm_get(&vmm, ADDR, true, page, 0, ssize, &sparse);
+		if (ret)
+			goto done_vmm;
+	}
+
+	if (msize) {
+		if ((mclass = nvif_mclass(&mmu.object, mems)) < 0 ||
+		    (type = nvif_mmu_type(&mmu, vram ? NVIF_MEM_VRAM :
+							NVIF_MEM_HOST)) < 0) {
+			ret = -ENODEV;
+			goto done_sparse;
+		}
+
+		mem = calloc(count, sizeof(*mem));
+		vma = calloc(count, sizeof(*vma));
+		if (!mem || !vma) {
+			ret = -ENOMEM;
+			goto done_sparse;
+		}
+
+		for (i = 0; i < count; i++) {
+			ret = nvif_mem_init_type(&mmu, mems[mclass].oclass, type,
+						 vram ? page : PAGE_SHIFT,
+						 msize, NULL, 0, &mem[i]);
+			if (ret)
+				goto done_mem;
+
+			if (ssize) {
+				addr = sparse.addr + (ssize / count) * i;
+				addr &= ~((1ULL << page) - 1);
+			} else {
+				ret = nvif_vmm_get(&vmm, LAZY, false, page, 0,
+						   msize, &vma[i]);
+				if (ret)
+					goto done_mem;
+				addr = vma[i].addr;
+			}
+
+			ret = nvif_vmm_map(&vmm, addr, msize, NULL, 0,
+					   &mem[i], 0);
+			if (ret)
+				goto done_mem;
+		}
+	}
+
+	ret = print_footprint(&vmm);
+
+done_mem:
+	for (i = 0; mem && i < count; i++) {
+		nvif_vmm_put(&vmm, &vma[i]);
+		nvif_mem_fini(&mem[i]);
+	}
+	free(vma);
+	free(mem);
+done_sparse:
+	nvif_vmm_put(&vmm, &sparse);
+done_vmm:
+	nvif_vmm_fini(&vmm);
+done_mmu:
+	nvif_mmu_fini(&mmu);
+done_device:
+	if (ret)
+		printf("%s\n", strerror(-ret));
+	nvif_device_fini(&device);
+	nvif_client_fini(&client);
+	return ret;
+}
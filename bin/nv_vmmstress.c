@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <nvif/client.h>
+#include <nvif/device.h>
+#include <nvif/class.h>
+#include <nvif/mem.h>
+#include <nvif/mmu.h>
+#include <nvif/vmm.h>
+#include <nvif/if000c.h>
+
+#include "util.h"
+
+/* Hammers the lockless VMA lookup (NVIF_VMM_V0_LOOKUP) from several threads,
+ * while others allocate, split (by mapping part of), merge (by unmapping)
+ * and free regions of the same VMM under its mutex.
+ *
+ * Every successful lookup must return a VMA that contains the address that
+ * was looked up, anything else means a reader saw a torn update.
+ */
+#define SLOTS 64
+
+static struct nvif_vmm vmm;
+static struct nvif_mem mem;
+static u64 mem_size = 0x100000;
+static int page = 12;
+static u64 size = 0x1000000;
+static int count = 100000;
+
+static struct {
+	u64 addr;
+	u64 size;
+} slot[SLOTS];
+
+static volatile bool stop;
+
+static struct {
+	u64 lookups;
+	u64 found;
+	u64 missing;
+	u64 retried;
+	u64 bad;
+	u64 gets;
+	u64 maps;
+} stats;
+
+static void *
+reader(void *data)
+{
+	unsigned int seed = (unsigned long)data;
+	struct nvif_vmm_lookup_v0 args;
+	u64 addr, base, span;
+	int i, ret;
+
+	while (!stop) {
+		i = rand_r(&seed) % SLOTS;
+		base = __atomic_load_n(&slot[i].addr, __ATOMIC_ACQUIRE);
+		span = __atomic_load_n(&slot[i].size, __ATOMIC_ACQUIRE);
+		if (!base || !span)
+			continue;
+
+		addr = base + (((u64)rand_r(&seed) << page) % span);
+		ret = nvif_vmm_lookup(&vmm, addr, &args);
+		__atomic_add_fetch(&stats.lookups, 1, __ATOMIC_RELAXED);
+		switch (ret) {
+		case 0:
+			if (addr < args.addr || addr >= args.addr + args.size ||
+			    (args.addr & ((1ULL << page) - 1))) {
+				printf("bad: %016llx in %016llx-%016llx\n", addr,
+				       args.addr, args.addr + args.size);
+				__atomic_add_fetch(&stats.bad, 1,
+						   __ATOMIC_RELAXED);
+			}
+			__atomic_add_fetch(&stats.found, 1, __ATOMIC_RELAXED);
+			break;
+		case -ENOENT:
+			__atomic_add_fetch(&stats.missing, 1, __ATOMIC_RELAXED);
+			break;
+		case -EAGAIN:
+			__atomic_add_fetch(&stats.retried, 1, __ATOMIC_RELAXED);
+			break;
+		default:
+			printf("lookup: %d\n", ret);
+			__atomic_add_fetch(&stats.bad, 1, __ATOMIC_RELAXED);
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+static void *
+writer(void *data)
+{
+	const int base = (unsigned long)data * (SLOTS / 2);
+	unsigned int seed = (unsigned long)data;
+	const u64 pages = size >> page;
+	struct nvif_vma vma[SLOTS / 2] = {};
+	u64 addr, msize;
+	int i, n, ret;
+
+	for (n = 0; n < count && !stop; n++) {
+		i = rand_r(&seed) % (SLOTS / 2);
+
+		if (vma[i].size) {
+			__atomic_store_n(&slot[base + i].size, 0,
+					 __ATOMIC_RELEASE);
+			nvif_vmm_put(&vmm, &vma[i]);
+			continue;
+		}
+
+		ret = nvif_vmm_get(&vmm, ADDR, false, page, 0,
+				   (1 + rand_r(&seed) % pages) << page, &vma[i]);
+		if (ret) {
+			printf("get: %d\n", ret);
+			break;
+		}
+
+		__atomic_add_fetch(&stats.gets, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&slot[base + i].addr, vma[i].addr,
+				 __ATOMIC_RELEASE);
+		__atomic_store_n(&slot[base + i].size, vma[i].size,
+				 __ATOMIC_RELEASE);
+
+		/* Map, and unmap, a piece from the middle of the region to
+		 * split it into three VMAs and merge it back together.
+		 */
+		msize = min_t(u64, vma[i].size, mem_size);
+		msize = (1 + rand_r(&seed) % (msize >> page)) << page;
+		addr  = vma[i].addr + ((rand_r(&seed) %
+			(((vma[i].size - msize) >> page) + 1)) << page);
+
+		ret = nvif_vmm_map(&vmm, addr, msize, NULL, 0, &mem, 0);
+		if (ret == 0) {
+			__atomic_add_fetch(&stats.maps, 1, __ATOMIC_RELAXED);
+			nvif_vmm_unmap(&vmm, addr);
+		}
+	}
+
+	for (i = 0; i < SLOTS / 2; i++) {
+		__atomic_store_n(&slot[base + i].size, 0, __ATOMIC_RELEASE);
+		nvif_vmm_put(&vmm, &vma[i]);
+	}
+
+	return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+	static const struct nvif_mclass
+	mems[] = {
+		{ NVIF_CLASS_MEM_GF100, -1 },
+		{ NVIF_CLASS_MEM_NV50 , -1 },
+		{ NVIF_CLASS_MEM_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	mmus[] = {
+		{ NVIF_CLASS_MMU_GF100, -1 },
+		{ NVIF_CLASS_MMU_NV50 , -1 },
+		{ NVIF_CLASS_MMU_NV04 , -1 },
+		{}
+	};
+	static const struct nvif_mclass
+	vmms[] = {
+		{ NVIF_CLASS_VMM_GP100, -1 },
+		{ NVIF_CLASS_VMM_GM200, -1 },
+		{ NVIF_CLASS_VMM_GF100, -1 },
+		{ NVIF_CLASS_VMM_NV50 , -1 },
+		{ NVIF_CLASS_VMM_NV04 , -1 },
+		{}
+	};
+	struct nvif_client client;
+	struct nvif_device device;
+	struct nvif_mmu mmu;
+	pthread_t rd[16], wr[2];
+	int mclass, type, readers = 4, nr = 0, nw;
+	int ret, c;
+
+	while ((c = getopt(argc, argv, "n:p:s:t:"U_GETOPT)) != -1) {
+		switch (c) {
+		case 'n': count = strtol(optarg, NULL, 0); break;
+		case 'p': page = strtol(optarg, NULL, 0); break;
+		case 's': size = strtoull(optarg, NULL, 0); break;
+		case 't': readers = strtol(optarg, NULL, 0); break;
+		default:
+			if (!u_option(c))
+				return 1;
+			break;
+		}
+	}
+
+	if (count < 1 || readers < 1 || readers > ARRAY_SIZE(rd) ||
+	    (size >> page) < 1)
+		return 1;
+
+	ret = u_device("lib", argv[0], "error", true, true, ~0ULL,
+		       0x00000000, &client, &device);
+	if (ret)
+		return ret;
+
+	if ((ret = nvif_mclass(&device.object, mmus)) < 0 ||
+	    (ret = nvif_mmu_init(&device.object, mmus[ret].oclass, &mmu)))
+		goto done_device;
+
+	if ((ret = nvif_mclass(&mmu.object, vmms)) < 0 ||
+	    (ret = nvif_vmm_init(&mmu, vmms[ret].oclass, PAGE_SIZE, 0,
+				 NULL, 0, &vmm)))
+		goto done_mmu;
+
+	if ((mclass = nvif_mclass(&mmu.object, mems)) < 0 ||
+	    (type = nvif_mmu_type(&mmu, NVIF_MEM_HOST)) < 0) {
+		ret = -ENODEV;
+		goto done_vmm;
+	}
+
+	mem_size = max_t(u64, mem_size, 1ULL << page);
+	ret = nvif_mem_init_type(&mmu, mems[mclass].oclass, type, PAGE_SHIFT,
+				 mem_size, NULL, 0, &mem);
+	if (ret)
+		goto done_vmm;
+
+	for (nr = 0; nr < readers; nr++) {
+		if ((ret = -pthread_create(&rd[nr], NULL, reader,
+					   (void *)(unsigned long)(nr + 1))))
+			break;
+	}
+
+	for (nw = 0; !ret && nw < ARRAY_SIZE(wr); nw++) {
+		if ((ret = -pthread_create(&wr[nw], NULL, writer,
+					   (void *)(unsigned long)nw)))
+			break;
+	}
+
+	while (nw--)
+		pthread_join(wr[nw], NULL);
+	stop = true;
+	while (nr--)
+		pthread_join(rd[nr], NULL);
+
+	printf("%llu gets, %llu maps\n", stats.gets, stats.maps);
+	printf("%llu lookups: %llu found, %llu missing, %llu retried, "
+	       "%llu bad\n", stats.lookups, stats.found, stats.missing,
+	       stats.retried, stats.bad);
+	if (!ret && stats.bad)
+		ret = -EINVAL;
+
+	nvif_mem_fini(&mem);
+done_vmm:
+	nvif_vmm_fini(&vmm);
+done_mmu:
+	nvif_mmu_fini(&mmu);
+done_device:
+	if (ret)
+		printf("%s\n", strerror(-ret));
+	nvif_device_fini(&device);
+	nvif_client_fini(&client);
+	return ret;
+}
@@ -9,6 +9,7 @@ struct nvif_client_v0 {
 };
 
 #define NVIF_CLIENT_V0_DEVLIST                                             0x00
+#define NVIF_CLIENT_V0_MEMORY                                              0x01
 
 struct nvif_client_devlist_v0 {
 	__u8  version;
@@ -16,4 +17,13 @@ struct nvif_client_devlist_v0 {
 	__u8  pad02[6];
 	__u64 device[];
 };
+
+struct nvif_client_memory_v0 {
+	__u8  version;
+	__u8  pad01[7];
+	__u64 vram;
+	__u64 host;
+	__u64 pgt;
+	__u64 chan;
+};
 #endif
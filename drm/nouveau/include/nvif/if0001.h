@@ -4,6 +4,9 @@
 #define NVIF_CONTROL_PSTATE_INFO                                           0x00
 #define NVIF_CONTROL_PSTATE_ATTR                                           0x01
 #define NVIF_CONTROL_PSTATE_USER                                           0x02
+#define NVIF_CONTROL_TIME_INFO                                             0x03
+#define NVIF_CONTROL_TIME_ATTR                                             0x04
+#define NVIF_CONTROL_STAT_ATTR                                             0x05
 
 struct nvif_control_pstate_info_v0 {
 	__u8  version;
@@ -43,4 +46,44 @@ struct nvif_control_pstate_user_v0 {
 	__s8  pwrsrc; /*  in: target power source */
 	__u8  pad03[5];
 };
+
+/* all times are in microseconds, and refer to the most recent invocation */
+struct nvif_control_time_info_v0 {
+	__u8  version;
+	__u8  pad01[7];
+	__s64 preinit; /* out: device preinit, including post */
+	__s64 post; /* out: devinit post */
+	__s64 init; /* out: device init (or resume) */
+	__s64 fini; /* out: device fini */
+	__s64 suspend; /* out: device suspend */
+};
+
+struct nvif_control_time_attr_v0 {
+	__u8  version;
+	__u8  index; /*  in: index of subdev to query
+		      * out: index of next subdev, or 0 if no more
+		      */
+	__u8  pad02[6];
+	__s64 preinit;
+	__s64 oneinit;
+	__s64 init; /* includes oneinit, on the first init */
+	__s64 fini;
+	__s64 suspend;
+	char  name[16];
+};
+
+/* statistics are cumulative since the device was created */
+struct nvif_control_stat_attr_v0 {
+	__u8  version;
+	__u8  subdev; /*  in: index of subdev to query
+		       * out: index of subdev with next counter, or 0 if no more
+		       */
+	__u8  index; /*  in: index of counter to query
+		      * out: index of next counter, or 0 if no more
+		      */
+	__u8  pad03[5];
+	__u64 value;
+	char  owner[16]; /* out: name of subdev */
+	char  name[32];
+};
 #endif
@@ -14,6 +14,9 @@ struct nvif_vmm_v0 {
 #define NVIF_VMM_V0_PUT                                                    0x02
 #define NVIF_VMM_V0_MAP                                                    0x03
 #define NVIF_VMM_V0_UNMAP                                                  0x04
+#define NVIF_VMM_V0_BIND                                                   0x05
+#define NVIF_VMM_V0_FOOTPRINT                                              0x06
+#define NVIF_VMM_V0_LOOKUP                                                 0x07
 
 struct nvif_vmm_page_v0 {
 	__u8  version;
@@ -61,4 +64,70 @@ struct nvif_vmm_unmap_v0 {
 	__u8  pad01[7];
 	__u64 addr;
 };
+
+struct nvif_vmm_bind_v0 {
+	__u8  version;
+	__u8  pad01[3];
+	__u32 count;
+	__u8  data[]; /* struct nvif_vmm_bind_op_v0[count] */
+};
+
+struct nvif_vmm_bind_op_v0 {
+#define NVIF_VMM_BIND_OP_V0_MAP                                            0x00
+#define NVIF_VMM_BIND_OP_V0_UNMAP                                          0x01
+	__u8  op;
+	__u8  argc;
+	__u8  pad02[2];
+	__s32 result;
+	__u64 addr;
+	__u64 size;
+	__u64 memory;
+	__u64 offset;
+	__u8  data[]; /* argc bytes of map args, padded to 8 bytes */
+};
+
+struct nvif_vmm_lookup_v0 {
+	__u8  version;
+	__u8  mapped;
+	__u8  sparse;
+	__u8  user;
+	__u8  pad04[4];
+	__u64 addr; /* in: address to look up, out: start of the VMA */
+	__u64 size;
+};
+
+struct nvif_vmm_footprint_level_v0 {
+#define NVIF_VMM_FOOTPRINT_LEVEL_V0_PGD                                    0x00
+#define NVIF_VMM_FOOTPRINT_LEVEL_V0_PGT                                    0x01
+#define NVIF_VMM_FOOTPRINT_LEVEL_V0_SPT                                    0x02
+#define NVIF_VMM_FOOTPRINT_LEVEL_V0_LPT                                    0x03
+	__u8  type;
+	__u8  bits;
+	__u8  pad02[2];
+	__u32 tables;
+	__u32 hwpts;
+	__u32 sparse;
+	__u64 refs;
+	__u64 bytes;
+	__u64 swbytes;
+};
+
+struct nvif_vmm_footprint_page_v0 {
+	__u8  shift;
+	__u8  pad01[7];
+	__u64 mapped;
+};
+
+struct nvif_vmm_footprint_v0 {
+	__u8  version;
+	__u8  level_nr; /* level[0] is the root of the page-table tree */
+	__u8  page_nr;
+	__u8  pad03[5];
+	__u64 mapped_addr;
+	__u64 mapped_size;
+	__u64 unmapped_addr;
+	__u64 unmapped_size;
+	struct nvif_vmm_footprint_level_v0 level[8];
+	struct nvif_vmm_footprint_page_v0 page[8];
+};
 #endif
@@ -3,6 +3,8 @@
 #include <nvif/object.h>
 struct nvif_mem;
 struct nvif_mmu;
+struct nvif_vmm_footprint_v0;
+struct nvif_vmm_lookup_v0;
 
 enum nvif_vmm_get {
 	ADDR,
@@ -15,6 +17,17 @@ struct nvif_vma {
 	u64 size;
 };
 
+struct nvif_vmm_bind {
+	bool unmap;
+	u64 addr;
+	u64 size;
+	struct nvif_mem *mem;
+	u64 offset;
+	void *argv;
+	u32 argc;
+	int result;
+};
+
 struct nvif_vmm {
 	struct nvif_object object;
 	u64 start;
@@ -39,4 +52,7 @@ void nvif_vmm_put(struct nvif_vmm *, struct nvif_vma *);
 int nvif_vmm_map(struct nvif_vmm *, u64 addr, u64 size, void *argv, u32 argc,
 		 struct nvif_mem *, u64 offset);
 int nvif_vmm_unmap(struct nvif_vmm *, u64);
+int nvif_vmm_bind(struct nvif_vmm *, struct nvif_vmm_bind *, int nr);
+int nvif_vmm_footprint(struct nvif_vmm *, struct nvif_vmm_footprint_v0 *);
+int nvif_vmm_lookup(struct nvif_vmm *, u64 addr, struct nvif_vmm_lookup_v0 *);
 #endif
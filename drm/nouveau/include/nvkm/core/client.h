@@ -3,6 +3,14 @@
 #define nvkm_client(p) container_of((p), struct nvkm_client, object)
 #include <core/object.h>
 
+enum nvkm_client_mem {
+	NVKM_CLIENT_MEM_VRAM, /* User buffers in VRAM. */
+	NVKM_CLIENT_MEM_HOST, /* User buffers in system memory. */
+	NVKM_CLIENT_MEM_PGT, /* Page tables of user VMMs. */
+	NVKM_CLIENT_MEM_CHAN, /* Channel instance blocks, engine contexts. */
+	NVKM_CLIENT_MEM_NR
+};
+
 struct nvkm_client {
 	struct nvkm_object object;
 	char name[32];
@@ -18,8 +26,18 @@ struct nvkm_client {
 
 	struct list_head umem;
 	spinlock_t lock;
+
+	/* Memory owned by objects of this client, in bytes. */
+	atomic64_t mem[NVKM_CLIENT_MEM_NR];
 };
 
+static inline void
+nvkm_client_charge(struct nvkm_client *client, enum nvkm_client_mem type,
+		   s64 bytes)
+{
+	atomic64_add(bytes, &client->mem[type]);
+}
+
 int  nvkm_client_new(const char *name, u64 device, const char *cfg,
 		     const char *dbg,
 		     int (*)(const void *, u32, const void *, u32),
@@ -95,6 +95,15 @@ struct nvkm_device {
 	u64 disable_mask;
 	u32 debug;
 
+	/* duration (in usecs) of most recent invocation of each stage */
+	struct {
+		s64 preinit;
+		s64 post;
+		s64 init;
+		s64 fini;
+		s64 suspend;
+	} time;
+
 	const struct nvkm_device_chip *chip;
 	enum {
 		NV_04    = 0x04,
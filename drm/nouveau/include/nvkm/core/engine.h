@@ -22,6 +22,7 @@ struct nvkm_engine_func {
 	void (*intr)(struct nvkm_engine *);
 	void (*tile)(struct nvkm_engine *, int region, struct nvkm_fb_tile *);
 	bool (*chsw_load)(struct nvkm_engine *);
+	void (*stat)(struct nvkm_engine *, struct nvkm_subdev_stat *);
 
 	struct {
 		int (*sclass)(struct nvkm_oclass *, int index,
@@ -6,8 +6,11 @@ struct nvkm_vma;
 struct nvkm_vmm;
 
 struct nvkm_tags {
-	struct nvkm_mm_node *mn;
+	u32 offset;
+	u32 nr; /* Zero if HW comptags couldn't be allocated. */
+	u64 clear; /* LTC clear to wait for before first use, if non-zero. */
 	refcount_t refcount;
+	struct rcu_head rcu;
 };
 
 enum nvkm_memory_target {
@@ -35,11 +38,20 @@ struct nvkm_memory_func {
 	void (*release)(struct nvkm_memory *);
 	int (*map)(struct nvkm_memory *, u64 offset, struct nvkm_vmm *,
 		   struct nvkm_vma *, void *argv, u32 argc);
+	/* as map(), with the VMM's mutex already held by the caller */
+	int (*map_locked)(struct nvkm_memory *, u64 offset, struct nvkm_vmm *,
+			  struct nvkm_vma *, void *argv, u32 argc);
 };
 
 struct nvkm_memory_ptrs {
 	u32 (*rd32)(struct nvkm_memory *, u64 offset);
 	void (*wr32)(struct nvkm_memory *, u64 offset, u32 data);
+	/* optional accessors, emulated with rd32/wr32 if not present */
+	u64 (*rd64)(struct nvkm_memory *, u64 offset);
+	void (*wr64)(struct nvkm_memory *, u64 offset, u64 data);
+	void (*copy_to)(struct nvkm_memory *, u64 offset, const void *, u64 size);
+	void (*copy_from)(struct nvkm_memory *, u64 offset, void *, u64 size);
+	void (*fill)(struct nvkm_memory *, u64 offset, u32 data, u64 size);
 };
 
 void nvkm_memory_ctor(const struct nvkm_memory_func *, struct nvkm_memory *);
@@ -48,10 +60,16 @@ int nvkm_memory_new(struct nvkm_device *, enum nvkm_memory_target,
 struct nvkm_memory *nvkm_memory_ref(struct nvkm_memory *);
 void nvkm_memory_unref(struct nvkm_memory **);
 int nvkm_memory_tags_get(struct nvkm_memory *, struct nvkm_device *, u32 tags,
-			 void (*clear)(struct nvkm_device *, u32, u32),
+			 u64 (*clear)(struct nvkm_device *, u32, u32),
 			 struct nvkm_tags **);
 void nvkm_memory_tags_put(struct nvkm_memory *, struct nvkm_device *,
 			  struct nvkm_tags **);
+void nvkm_memory_copy_to(struct nvkm_memory *, u64 offset, const void *src,
+			 u64 size);
+void nvkm_memory_copy_from(struct nvkm_memory *, u64 offset, void *dst,
+			   u64 size);
+void nvkm_memory_fill(struct nvkm_memory *, u64 offset, u32 data, u64 size);
+void nvkm_memory_fill_io(void __iomem *, u64 data, u64 size);
 
 #define nvkm_memory_target(p) (p)->func->target(p)
 #define nvkm_memory_page(p) (p)->func->page(p)
@@ -60,9 +78,12 @@ void nvkm_memory_tags_put(struct nvkm_memory *, struct nvkm_device *,
 #define nvkm_memory_boot(p,v) (p)->func->boot((p),(v))
 #define nvkm_memory_map(p,o,vm,va,av,ac)                                       \
 	(p)->func->map((p),(o),(vm),(va),(av),(ac))
+#define nvkm_memory_map_locked(p,o,vm,va,av,ac)                                \
+	(p)->func->map_locked((p),(o),(vm),(va),(av),(ac))
 
 /* accessor macros - kmap()/done() must bracket use of the other accessor
- * macros to guarantee correct behaviour across all chipsets
+ * macros (and the nvkm_memory_copy/fill functions) to guarantee correct
+ * behaviour across all chipsets
  */
 #define nvkm_kmap(o)     (o)->func->acquire(o)
 #define nvkm_done(o)     (o)->func->release(o)
@@ -75,22 +96,42 @@ void nvkm_memory_tags_put(struct nvkm_memory *, struct nvkm_device *,
 	_data;                                                                 \
 })
 
+#define nvkm_ro64(o,a) ({                                                      \
+	u64 __a = (a), __d;                                                    \
+	if ((o)->ptrs->rd64) {                                                 \
+		__d = (o)->ptrs->rd64((o), __a);                               \
+	} else {                                                               \
+		__d  = nvkm_ro32((o), __a + 0);                                \
+		__d |= (u64)nvkm_ro32((o), __a + 4) << 32;                     \
+	}                                                                      \
+	__d;                                                                   \
+})
+
 #define nvkm_wo64(o,a,d) do {                                                  \
 	u64 __a = (a), __d = (d);                                              \
-	nvkm_wo32((o), __a + 0, lower_32_bits(__d));                           \
-	nvkm_wo32((o), __a + 4, upper_32_bits(__d));                           \
+	if ((o)->ptrs->wr64) {                                                 \
+		(o)->ptrs->wr64((o), __a, __d);                                \
+	} else {                                                               \
+		nvkm_wo32((o), __a + 0, lower_32_bits(__d));                   \
+		nvkm_wo32((o), __a + 4, upper_32_bits(__d));                   \
+	}                                                                      \
 } while(0)
 
+/* Repeated 32-bit patterns (and 64-bit ones made of two identical halves,
+ * ie. zero/invalid PTEs) go through the backend's bulk fill, which uses the
+ * widest stores it safely can.  Other 64-bit patterns use 64-bit stores when
+ * the backend provides a CPU mapping and native 64-bit accessors.
+ */
 #define nvkm_fill(t,s,o,a,d,c) do {                                            \
 	u64 _a = (a), _c = (c), _d = (d), _o = _a >> s, _s = _c << s;          \
 	u##t __iomem *_m = nvkm_kmap(o);                                       \
-	if (likely(_m)) {                                                      \
-		if (_d) {                                                      \
-			while (_c--)                                           \
-				iowrite##t##_native(_d, &_m[_o++]);            \
-		} else {                                                       \
-			memset_io(&_m[_o], _d, _s);                            \
-		}                                                              \
+	if (t == 32)                                                           \
+		_d |= _d << 32;                                                \
+	if (lower_32_bits(_d) == upper_32_bits(_d)) {                          \
+		nvkm_memory_fill((o), _a, lower_32_bits(_d), _s);              \
+	} else                                                                 \
+	if (likely(_m) && (o)->ptrs->wr64) {                                   \
+		nvkm_memory_fill_io(&_m[_o], _d, _s);                          \
 	} else {                                                               \
 		for (; _c; _c--, _a += BIT(s))                                 \
 			nvkm_wo##t((o), _a, _d);                               \
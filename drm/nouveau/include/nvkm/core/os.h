@@ -14,6 +14,16 @@
 #define iowrite32_native iowrite32
 #endif
 
+#if defined(CONFIG_64BIT) && defined(writeq) && !defined(__BIG_ENDIAN)
+#define ioread64_native(p) readq(p)
+#define iowrite64_native(v,p) writeq((v), (p))
+#else
+#define ioread64_native(p) ({                                                  \
+	u32 __iomem *_p = (u32 __iomem *)(p);				       \
+	u64 _v = ioread32_native(&_p[0]);				       \
+	_v | ((u64)ioread32_native(&_p[1]) << 32);			       \
+})
+
 #define iowrite64_native(v,p) do {                                             \
 	u32 __iomem *_p = (u32 __iomem *)(p);				       \
 	u64 _v = (v);							       \
@@ -21,3 +31,4 @@
 	iowrite32_native(upper_32_bits(_v), &_p[1]);			       \
 } while(0)
 #endif
+#endif
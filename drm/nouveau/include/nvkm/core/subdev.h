@@ -10,6 +10,22 @@ struct nvkm_subdev {
 	u32 debug;
 
 	bool oneinit;
+
+	/* duration (in usecs) of most recent invocation of each stage */
+	struct {
+		s64 preinit;
+		s64 oneinit;
+		s64 init;
+		s64 fini;
+		s64 suspend;
+	} time;
+};
+
+/* Used to fetch a single counter, of those a subdev reports via nvkm_stat(). */
+struct nvkm_subdev_stat {
+	int index;
+	const char *name;
+	u64 value;
 };
 
 struct nvkm_subdev_func {
@@ -19,6 +35,8 @@ struct nvkm_subdev_func {
 	int (*init)(struct nvkm_subdev *);
 	int (*fini)(struct nvkm_subdev *, bool suspend);
 	void (*intr)(struct nvkm_subdev *);
+	/* Reports every counter, in a fixed order, with nvkm_stat(). */
+	void (*stat)(struct nvkm_subdev *, struct nvkm_subdev_stat *);
 };
 
 extern const char *nvkm_subdev_name[NVKM_SUBDEV_NR];
@@ -29,6 +47,17 @@ int  nvkm_subdev_preinit(struct nvkm_subdev *);
 int  nvkm_subdev_init(struct nvkm_subdev *);
 int  nvkm_subdev_fini(struct nvkm_subdev *, bool suspend);
 void nvkm_subdev_intr(struct nvkm_subdev *);
+bool nvkm_subdev_stat(struct nvkm_subdev *, int index,
+		      struct nvkm_subdev_stat *);
+
+static inline void
+nvkm_stat(struct nvkm_subdev_stat *stat, const char *name, u64 value)
+{
+	if (stat->index-- == 0) {
+		stat->name = name;
+		stat->value = value;
+	}
+}
 
 /* subdev logging */
 #define nvkm_printk_(s,l,p,f,a...) do {                                        \
@@ -33,7 +33,16 @@ struct nvkm_fb {
 	struct nvkm_subdev subdev;
 
 	struct nvkm_ram *ram;
-	struct nvkm_mm tags;
+	struct nvkm_mm tags; /* NV20-NV40 tile regions. */
+
+	/* Comptags for compressed memory objects (NV50-). */
+	struct {
+		spinlock_t lock;
+		u32 nr;
+		unsigned long *used; /* Allocated comptags. */
+		unsigned long *full; /* Words of used[] with no free comptags. */
+		u32 busy; /* Comptags currently allocated. */
+	} comptags;
 
 	struct {
 		struct nvkm_fb_tile region[16];
@@ -46,6 +55,11 @@ struct nvkm_fb {
 	struct nvkm_memory *mmu_wr;
 };
 
+int  nvkm_fb_tags_init(struct nvkm_fb *, u32 nr);
+void nvkm_fb_tags_fini(struct nvkm_fb *);
+int  nvkm_fb_tags_get(struct nvkm_fb *, u32 nr, u32 *offset);
+void nvkm_fb_tags_put(struct nvkm_fb *, u32 offset, u32 nr);
+
 void nvkm_fb_tile_init(struct nvkm_fb *, int region, u32 addr, u32 size,
 		       u32 pitch, u32 flags, struct nvkm_fb_tile *);
 void nvkm_fb_tile_fini(struct nvkm_fb *, int region, struct nvkm_fb_tile *);
@@ -117,6 +131,14 @@ struct nvkm_ram {
 #define NVKM_RAM_MM_NOMAP  (NVKM_MM_HEAP_ANY + 2)
 #define NVKM_RAM_MM_MIXED  (NVKM_MM_HEAP_ANY + 3)
 	struct nvkm_mm vram;
+
+	/* Per-heap, per-order pools of 2MiB superblocks with free space. */
+#define NVKM_RAM_BUDDY_ORDERS 10
+	struct {
+		struct list_head free[NVKM_RAM_MM_MIXED + 1]
+				     [NVKM_RAM_BUDDY_ORDERS];
+		struct rb_root tree;
+	} buddy;
 	u64 stolen;
 
 	int ranks;
@@ -131,8 +153,33 @@ struct nvkm_ram {
 	struct nvkm_ram_data former;
 	struct nvkm_ram_data xition;
 	struct nvkm_ram_data target;
+
+	/* Previously built reclocking scripts, most recently used first. */
+	struct {
+		struct mutex mutex;
+		struct list_head list;
+		int nr;
+		u8 strap;
+		u64 hits;
+		u64 misses;
+		u64 flushes;
+
+		/* Register writes requested, and merged into another. */
+		u64 wr32;
+		u64 merged;
+	} script;
 };
 
+/* Identifies a (step of a) memory clock transition. */
+struct nvkm_ram_script_key {
+	u32 from;
+	u32 to;
+	u8 step;
+	u32 state; /* Any other state the script depends on. */
+};
+
+void nvkm_ram_script_flush(struct nvkm_ram *);
+
 int
 nvkm_ram_get(struct nvkm_device *, u8 heap, u8 type, u8 page, u64 size,
 	     bool contig, bool back, struct nvkm_memory **);
@@ -12,6 +12,14 @@ struct nvkm_instmem {
 	struct list_head boot;
 	u32 reserved;
 
+	/* suspend/resume volume (in bytes) from the most recent cycle */
+	struct {
+		u64 saved;
+		u64 kept;
+		u64 discarded;
+		u64 restored;
+	} suspend;
+
 	struct nvkm_memory *vbios;
 	struct nvkm_ramht  *ramht;
 	struct nvkm_memory *ramro;
@@ -20,9 +28,25 @@ struct nvkm_instmem {
 
 u32 nvkm_instmem_rd32(struct nvkm_instmem *, u32 addr);
 void nvkm_instmem_wr32(struct nvkm_instmem *, u32 addr, u32 data);
+void nvkm_instmem_bar2_fini(struct nvkm_instmem *);
 int nvkm_instobj_new(struct nvkm_instmem *, u32 size, u32 align, bool zero,
 		     struct nvkm_memory **);
 
+/* How an object's contents are to be handled across suspend/resume. */
+enum nvkm_instobj_preserve {
+	/* Copied out on suspend, and back in on resume (default). */
+	NVKM_INSTOBJ_PRESERVE,
+	/* Contents are never modified once written.  A copy is taken on
+	 * the first suspend, and kept to restore from on every resume.
+	 */
+	NVKM_INSTOBJ_CONST,
+	/* Contents are regenerated by the owner on init, or don't matter. */
+	NVKM_INSTOBJ_DISCARD,
+};
+
+void nvkm_instobj_preserve(struct nvkm_instmem *, struct nvkm_memory *,
+			   enum nvkm_instobj_preserve);
+
 
 int nv04_instmem_new(struct nvkm_device *, int, struct nvkm_instmem **);
 int nv40_instmem_new(struct nvkm_device *, int, struct nvkm_instmem **);
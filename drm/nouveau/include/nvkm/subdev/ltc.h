@@ -16,13 +16,22 @@ struct nvkm_ltc {
 	u32 tag_base;
 	struct nvkm_memory *tag_ram;
 
+	struct {
+		u64 issued; /* Sequence number of the last clear issued. */
+		u64 done; /* Sequence number of the last clear completed. */
+		u64 waits; /* Number of times we've polled for completion. */
+		u64 wait_ns; /* Total time spent polling for completion. */
+		u64 wait_max_ns; /* Longest single wait for a clear. */
+	} cbc;
+
 	int zbc_min;
 	int zbc_max;
 	u32 zbc_color[NVKM_LTC_MAX_ZBC_CNT][4];
 	u32 zbc_depth[NVKM_LTC_MAX_ZBC_CNT];
 };
 
-void nvkm_ltc_tags_clear(struct nvkm_device *, u32 first, u32 count);
+u64  nvkm_ltc_tags_clear(struct nvkm_device *, u32 first, u32 count);
+void nvkm_ltc_tags_wait(struct nvkm_device *, u64 clear);
 
 int nvkm_ltc_zbc_color_get(struct nvkm_ltc *, int index, const u32[4]);
 int nvkm_ltc_zbc_depth_get(struct nvkm_ltc *, int index, const u32);
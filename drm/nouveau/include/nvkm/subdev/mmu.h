@@ -18,6 +18,23 @@ struct nvkm_vma {
 	bool busy:1; /* Region busy (for temporarily preventing user access). */
 	struct nvkm_memory *memory; /* Memory currently mapped into VMA. */
 	struct nvkm_tags *tags; /* Compression tag reference. */
+
+	/* Free tree only: the largest free block in this subtree that
+	 * remains once aligned to each of the tracked alignment classes.
+	 */
+#define NVKM_VMA_FREE_NR 4
+	u64 free[NVKM_VMA_FREE_NR];
+
+	struct rcu_head rcu; /* Lockless lookups may still be referencing. */
+};
+
+/* Snapshot of an allocated VMA, as returned by nvkm_vmm_node_lookup(). */
+struct nvkm_vma_info {
+	u64 addr;
+	u64 size;
+	bool mapped:1;
+	bool sparse:1;
+	bool user:1;
 };
 
 struct nvkm_vmm {
@@ -38,9 +55,31 @@ struct nvkm_vmm {
 	struct rb_root free;
 	struct rb_root root;
 
+	struct {
+		seqcount_t seq; /* Changes to root, for lockless lookups. */
+		u32 depth; /* nvkm_vmm_node_write_begin() nesting level. */
+	} lookup;
+
 	bool bootstrapped;
 	atomic_t engref[NVKM_SUBDEV_NR];
 
+	struct {
+		u32 defer; /* nvkm_vmm_flush_begin() nesting level. */
+		u64 tags; /* Comptag clear to wait for before returning. */
+		int depth; /* Highest PT level with a pending invalidate. */
+		struct list_head release; /* Memory unmapped before it. */
+		u64 issued; /* Invalidates sent to the MMU. */
+		u64 avoided; /* Invalidates merged into another. */
+	} flush;
+
+	struct {
+		bool enabled; /* Map contiguous memory with larger pages. */
+		u64 maps; /* Number of mappings promoted. */
+		u64 bytes; /* Address-space mapped with promoted pages. */
+	} promote;
+
+	u64 pt_bytes; /* GPU memory allocated for page tables. */
+
 	dma_addr_t null;
 	void *nullp;
 };
@@ -53,6 +92,7 @@ int nvkm_vmm_boot(struct nvkm_vmm *);
 int nvkm_vmm_join(struct nvkm_vmm *, struct nvkm_memory *inst);
 void nvkm_vmm_part(struct nvkm_vmm *, struct nvkm_memory *inst);
 int nvkm_vmm_get(struct nvkm_vmm *, u8 page, u64 size, struct nvkm_vma **);
+int nvkm_vmm_node_lookup(struct nvkm_vmm *, u64 addr, struct nvkm_vma_info *);
 void nvkm_vmm_put(struct nvkm_vmm *, struct nvkm_vma **);
 
 struct nvkm_vmm_map {
@@ -74,6 +114,8 @@ struct nvkm_vmm_map {
 
 int nvkm_vmm_map(struct nvkm_vmm *, struct nvkm_vma *, void *argv, u32 argc,
 		 struct nvkm_vmm_map *);
+int nvkm_vmm_map_locked(struct nvkm_vmm *, struct nvkm_vma *,
+			void *argv, u32 argc, struct nvkm_vmm_map *);
 void nvkm_vmm_unmap(struct nvkm_vmm *, struct nvkm_vma *);
 
 struct nvkm_memory *nvkm_umem_search(struct nvkm_client *, u64);
@@ -110,7 +152,20 @@ struct nvkm_mmu {
 	struct {
 		struct mutex mutex;
 		struct list_head list;
-	} ptc, ptp;
+		struct nvkm_mmu_ptc *find[32]; /* Last match, by size order. */
+		u64 bytes; /* Total size of cached page tables. */
+	} ptc;
+
+	struct {
+		struct mutex mutex;
+		struct list_head list;
+	} ptp;
+
+	struct {
+#define NVKM_MEM_HOST_ORDERS 3
+		atomic64_t chunks[NVKM_MEM_HOST_ORDERS]; /* 2MiB, 64KiB, 4KiB. */
+		atomic64_t fallback; /* Failed high-order attempts. */
+	} host;
 
 	struct nvkm_device_oclass user;
 };
@@ -46,7 +46,18 @@ int gp102_pmu_new(struct nvkm_device *, int, struct nvkm_pmu **);
 struct nvkm_memx;
 int  nvkm_memx_init(struct nvkm_pmu *, struct nvkm_memx **);
 int  nvkm_memx_fini(struct nvkm_memx **, bool exec);
+
+/* previously built script, that can be executed multiple times */
+struct nvkm_memx_script {
+	u32 words;
+	u32 data[];
+};
+
+struct nvkm_memx_script *nvkm_memx_script(struct nvkm_memx *);
+int  nvkm_memx_exec(struct nvkm_pmu *, const struct nvkm_memx_script *);
 void nvkm_memx_wr32(struct nvkm_memx *, u32 addr, u32 data);
+void nvkm_memx_wr32_elide(struct nvkm_memx *, u32 addr, u32 data);
+void nvkm_memx_elided(struct nvkm_memx *, u32 *wr32, u32 *merged);
 void nvkm_memx_wait(struct nvkm_memx *, u32 addr, u32 mask, u32 data, u32 nsec);
 void nvkm_memx_nsec(struct nvkm_memx *, u32 nsec);
 void nvkm_memx_wait_vblank(struct nvkm_memx *);
@@ -61,6 +61,71 @@ nvif_vmm_map(struct nvif_vmm *vmm, u64 addr, u64 size, void *argv, u32 argc,
 	return ret;
 }
 
+int
+nvif_vmm_bind(struct nvif_vmm *vmm, struct nvif_vmm_bind *bind, int nr)
+{
+	struct nvif_vmm_bind_v0 *args;
+	struct nvif_vmm_bind_op_v0 *op;
+	u32 argn = sizeof(*args);
+	u8 *data;
+	int ret, i;
+
+	for (i = 0; i < nr; i++) {
+		if (WARN_ON(bind[i].argc > 0xff))
+			return -EINVAL;
+		argn += sizeof(*op) + ALIGN(bind[i].argc, 8);
+	}
+
+	if (!(args = kzalloc(argn, GFP_KERNEL)))
+		return -ENOMEM;
+	args->version = 0;
+	args->count = nr;
+
+	for (data = args->data, i = 0; i < nr; i++) {
+		op = (void *)data;
+		if (bind[i].unmap) {
+			op->op = NVIF_VMM_BIND_OP_V0_UNMAP;
+		} else {
+			op->op = NVIF_VMM_BIND_OP_V0_MAP;
+			op->size = bind[i].size;
+			op->memory = nvif_handle(&bind[i].mem->object);
+			op->offset = bind[i].offset;
+			op->argc = bind[i].argc;
+			memcpy(op->data, bind[i].argv, bind[i].argc);
+		}
+		op->addr = bind[i].addr;
+		data += sizeof(*op) + ALIGN(op->argc, 8);
+	}
+
+	ret = nvif_object_mthd(&vmm->object, NVIF_VMM_V0_BIND, args, argn);
+	for (data = args->data, i = 0; i < nr; i++) {
+		op = (void *)data;
+		bind[i].result = ret ? ret : op->result;
+		data += sizeof(*op) + ALIGN(op->argc, 8);
+	}
+
+	kfree(args);
+	return ret;
+}
+
+int
+nvif_vmm_footprint(struct nvif_vmm *vmm, struct nvif_vmm_footprint_v0 *args)
+{
+	memset(args, 0x00, sizeof(*args));
+	return nvif_object_mthd(&vmm->object, NVIF_VMM_V0_FOOTPRINT,
+				args, sizeof(*args));
+}
+
+int
+nvif_vmm_lookup(struct nvif_vmm *vmm, u64 addr,
+		struct nvif_vmm_lookup_v0 *args)
+{
+	memset(args, 0x00, sizeof(*args));
+	args->addr = addr;
+	return nvif_object_mthd(&vmm->object, NVIF_VMM_V0_LOOKUP,
+				args, sizeof(*args));
+}
+
 void
 nvif_vmm_put(struct nvif_vmm *vmm, struct nvif_vma *vma)
 {
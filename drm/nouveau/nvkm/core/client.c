@@ -214,6 +214,27 @@ nvkm_client_mthd_devlist(struct nvkm_client *client, void *data, u32 size)
 	return ret;
 }
 
+static int
+nvkm_client_mthd_memory(struct nvkm_client *client, void *data, u32 size)
+{
+	union {
+		struct nvif_client_memory_v0 v0;
+	} *args = data;
+	int ret = -ENOSYS;
+
+	nvif_ioctl(&client->object, "client memory size %d\n", size);
+	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
+		nvif_ioctl(&client->object, "client memory vers %d\n",
+			   args->v0.version);
+		args->v0.vram = atomic64_read(&client->mem[NVKM_CLIENT_MEM_VRAM]);
+		args->v0.host = atomic64_read(&client->mem[NVKM_CLIENT_MEM_HOST]);
+		args->v0.pgt  = atomic64_read(&client->mem[NVKM_CLIENT_MEM_PGT]);
+		args->v0.chan = atomic64_read(&client->mem[NVKM_CLIENT_MEM_CHAN]);
+	}
+
+	return ret;
+}
+
 static int
 nvkm_client_mthd(struct nvkm_object *object, u32 mthd, void *data, u32 size)
 {
@@ -221,6 +242,8 @@ nvkm_client_mthd(struct nvkm_object *object, u32 mthd, void *data, u32 size)
 	switch (mthd) {
 	case NVIF_CLIENT_V0_DEVLIST:
 		return nvkm_client_mthd_devlist(client, data, size);
+	case NVIF_CLIENT_V0_MEMORY:
+		return nvkm_client_mthd_memory(client, data, size);
 	default:
 		break;
 	}
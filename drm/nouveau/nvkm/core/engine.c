@@ -41,8 +41,9 @@ nvkm_engine_unref(struct nvkm_engine **pengine)
 	struct nvkm_engine *engine = *pengine;
 	if (engine) {
 		mutex_lock(&engine->subdev.mutex);
-		if (--engine->usecount == 0)
+		if (engine->usecount == 1)
 			nvkm_subdev_fini(&engine->subdev, false);
+		engine->usecount--;
 		mutex_unlock(&engine->subdev.mutex);
 		*pengine = NULL;
 	}
@@ -82,10 +83,27 @@ nvkm_engine_intr(struct nvkm_subdev *subdev)
 		engine->func->intr(engine);
 }
 
+static void
+nvkm_engine_stat(struct nvkm_subdev *subdev, struct nvkm_subdev_stat *stat)
+{
+	struct nvkm_engine *engine = nvkm_engine(subdev);
+	if (engine->func->stat)
+		engine->func->stat(engine, stat);
+}
+
 static int
 nvkm_engine_fini(struct nvkm_subdev *subdev, bool suspend)
 {
 	struct nvkm_engine *engine = nvkm_engine(subdev);
+
+	/* Engines are only initialised once they gain their first user, so
+	 * there's nothing to tear down (or save) for one that has none.
+	 */
+	if (!engine->usecount) {
+		nvkm_trace(subdev, "fini skipped, engine has no users\n");
+		return 0;
+	}
+
 	if (engine->func->fini)
 		return engine->func->fini(engine, suspend);
 	return 0;
@@ -151,6 +169,7 @@ nvkm_engine_func = {
 	.init = nvkm_engine_init,
 	.fini = nvkm_engine_fini,
 	.intr = nvkm_engine_intr,
+	.stat = nvkm_engine_stat,
 };
 
 int
@@ -41,6 +41,20 @@ nvkm_gpuobj_wr32_fast(struct nvkm_gpuobj *gpuobj, u32 offset, u32 data)
 	iowrite32_native(data, gpuobj->map + offset);
 }
 
+static void
+nvkm_gpuobj_copy_to_fast(struct nvkm_gpuobj *gpuobj, u32 offset,
+			 const void *src, u32 size)
+{
+	memcpy_toio(gpuobj->map + offset, src, size);
+}
+
+static void
+nvkm_gpuobj_copy_from_fast(struct nvkm_gpuobj *gpuobj, u32 offset,
+			   void *dst, u32 size)
+{
+	memcpy_fromio(dst, gpuobj->map + offset, size);
+}
+
 /* accessor functions for gpuobjs allocated directly from instmem */
 static int
 nvkm_gpuobj_heap_map(struct nvkm_gpuobj *gpuobj, u64 offset,
@@ -62,6 +76,20 @@ nvkm_gpuobj_heap_wr32(struct nvkm_gpuobj *gpuobj, u32 offset, u32 data)
 	nvkm_wo32(gpuobj->memory, offset, data);
 }
 
+static void
+nvkm_gpuobj_heap_copy_to(struct nvkm_gpuobj *gpuobj, u32 offset,
+			 const void *src, u32 size)
+{
+	nvkm_memory_copy_to(gpuobj->memory, offset, src, size);
+}
+
+static void
+nvkm_gpuobj_heap_copy_from(struct nvkm_gpuobj *gpuobj, u32 offset,
+			   void *dst, u32 size)
+{
+	nvkm_memory_copy_from(gpuobj->memory, offset, dst, size);
+}
+
 static const struct nvkm_gpuobj_func nvkm_gpuobj_heap;
 static void
 nvkm_gpuobj_heap_release(struct nvkm_gpuobj *gpuobj)
@@ -75,6 +103,8 @@ nvkm_gpuobj_heap_fast = {
 	.release = nvkm_gpuobj_heap_release,
 	.rd32 = nvkm_gpuobj_rd32_fast,
 	.wr32 = nvkm_gpuobj_wr32_fast,
+	.copy_to = nvkm_gpuobj_copy_to_fast,
+	.copy_from = nvkm_gpuobj_copy_from_fast,
 	.map = nvkm_gpuobj_heap_map,
 };
 
@@ -83,6 +113,8 @@ nvkm_gpuobj_heap_slow = {
 	.release = nvkm_gpuobj_heap_release,
 	.rd32 = nvkm_gpuobj_heap_rd32,
 	.wr32 = nvkm_gpuobj_heap_wr32,
+	.copy_to = nvkm_gpuobj_heap_copy_to,
+	.copy_from = nvkm_gpuobj_heap_copy_from,
 	.map = nvkm_gpuobj_heap_map,
 };
 
@@ -125,6 +157,22 @@ nvkm_gpuobj_wr32(struct nvkm_gpuobj *gpuobj, u32 offset, u32 data)
 	nvkm_wo32(gpuobj->parent, gpuobj->node->offset + offset, data);
 }
 
+static void
+nvkm_gpuobj_copy_to(struct nvkm_gpuobj *gpuobj, u32 offset,
+		    const void *src, u32 size)
+{
+	nvkm_gpuobj_memcpy_to(gpuobj->parent, gpuobj->node->offset + offset,
+			      src, size);
+}
+
+static void
+nvkm_gpuobj_copy_from(struct nvkm_gpuobj *gpuobj, u32 offset,
+		      void *dst, u32 size)
+{
+	nvkm_gpuobj_memcpy_from(dst, gpuobj->parent,
+				gpuobj->node->offset + offset, size);
+}
+
 static const struct nvkm_gpuobj_func nvkm_gpuobj_func;
 static void
 nvkm_gpuobj_release(struct nvkm_gpuobj *gpuobj)
@@ -138,6 +186,8 @@ nvkm_gpuobj_fast = {
 	.release = nvkm_gpuobj_release,
 	.rd32 = nvkm_gpuobj_rd32_fast,
 	.wr32 = nvkm_gpuobj_wr32_fast,
+	.copy_to = nvkm_gpuobj_copy_to_fast,
+	.copy_from = nvkm_gpuobj_copy_from_fast,
 	.map = nvkm_gpuobj_map,
 };
 
@@ -146,6 +196,8 @@ nvkm_gpuobj_slow = {
 	.release = nvkm_gpuobj_release,
 	.rd32 = nvkm_gpuobj_rd32,
 	.wr32 = nvkm_gpuobj_wr32,
+	.copy_to = nvkm_gpuobj_copy_to,
+	.copy_from = nvkm_gpuobj_copy_from,
 	.map = nvkm_gpuobj_map,
 };
 
@@ -258,21 +310,15 @@ nvkm_gpuobj_wrap(struct nvkm_memory *memory, struct nvkm_gpuobj **pgpuobj)
 }
 
 void
-nvkm_gpuobj_memcpy_to(struct nvkm_gpuobj *dst, u32 dstoffset, void *src,
-		      u32 length)
+nvkm_gpuobj_memcpy_to(struct nvkm_gpuobj *dst, u32 dstoffset,
+		      const void *src, u32 length)
 {
-	int i;
-
-	for (i = 0; i < length; i += 4)
-		nvkm_wo32(dst, dstoffset + i, *(u32 *)(src + i));
+	dst->func->copy_to(dst, dstoffset, src, length);
 }
 
 void
 nvkm_gpuobj_memcpy_from(void *dst, struct nvkm_gpuobj *src, u32 srcoffset,
 			u32 length)
 {
-	int i;
-
-	for (i = 0; i < length; i += 4)
-		((u32 *)src)[i / 4] = nvkm_ro32(src, srcoffset + i);
+	src->func->copy_from(src, srcoffset, dst, length);
 }
@@ -26,6 +26,82 @@
 #include <subdev/fb.h>
 #include <subdev/instmem.h>
 
+void
+nvkm_memory_copy_to(struct nvkm_memory *memory, u64 offset,
+		    const void *src, u64 size)
+{
+	const struct nvkm_memory_ptrs *ptrs = memory->ptrs;
+	u64 i;
+
+	if (ptrs->copy_to) {
+		ptrs->copy_to(memory, offset, src, size);
+		return;
+	}
+
+	for (i = 0; i < size; i += 4) {
+		u32 data;
+		if (unlikely(size - i < 4))
+			data = ptrs->rd32(memory, offset + i);
+		memcpy(&data, src + i, min_t(u64, size - i, 4));
+		ptrs->wr32(memory, offset + i, data);
+	}
+}
+
+void
+nvkm_memory_copy_from(struct nvkm_memory *memory, u64 offset,
+		      void *dst, u64 size)
+{
+	const struct nvkm_memory_ptrs *ptrs = memory->ptrs;
+	u64 i;
+
+	if (ptrs->copy_from) {
+		ptrs->copy_from(memory, offset, dst, size);
+		return;
+	}
+
+	for (i = 0; i < size; i += 4) {
+		u32 data = ptrs->rd32(memory, offset + i);
+		memcpy(dst + i, &data, min_t(u64, size - i, 4));
+	}
+}
+
+void
+nvkm_memory_fill(struct nvkm_memory *memory, u64 offset, u32 data, u64 size)
+{
+	const struct nvkm_memory_ptrs *ptrs = memory->ptrs;
+	u64 i;
+
+	if (ptrs->fill) {
+		ptrs->fill(memory, offset, data, size);
+		return;
+	}
+
+	for (i = 0; i < size; i += 4)
+		ptrs->wr32(memory, offset + i, data);
+}
+
+void
+nvkm_memory_fill_io(void __iomem *map, u64 data, u64 size)
+{
+	if (!data) {
+		memset_io(map, 0x00, size);
+		return;
+	}
+
+	if (size >= 4 && !IS_ALIGNED((unsigned long)map, 8)) {
+		iowrite32_native(lower_32_bits(data), map);
+		data = (data >> 32) | (data << 32);
+		map += 4;
+		size -= 4;
+	}
+
+	for (; size >= 8; size -= 8, map += 8)
+		iowrite64_native(data, map);
+
+	if (size >= 4)
+		iowrite32_native(lower_32_bits(data), map);
+}
+
 void
 nvkm_memory_tags_put(struct nvkm_memory *memory, struct nvkm_device *device,
 		     struct nvkm_tags **ptags)
@@ -35,9 +111,10 @@ nvkm_memory_tags_put(struct nvkm_memory *memory, struct nvkm_device *device,
 	if (tags) {
 		mutex_lock(&fb->subdev.mutex);
 		if (refcount_dec_and_test(&tags->refcount)) {
-			nvkm_mm_free(&fb->tags, &tags->mn);
-			kfree(memory->tags);
-			memory->tags = NULL;
+			if (tags->nr)
+				nvkm_fb_tags_put(fb, tags->offset, tags->nr);
+			rcu_assign_pointer(memory->tags, NULL);
+			kfree_rcu(tags, rcu);
 		}
 		mutex_unlock(&fb->subdev.mutex);
 		*ptags = NULL;
@@ -46,19 +123,39 @@ nvkm_memory_tags_put(struct nvkm_memory *memory, struct nvkm_device *device,
 
 int
 nvkm_memory_tags_get(struct nvkm_memory *memory, struct nvkm_device *device,
-		     u32 nr, void (*clr)(struct nvkm_device *, u32, u32),
+		     u32 nr, u64 (*clr)(struct nvkm_device *, u32, u32),
 		     struct nvkm_tags **ptags)
 {
 	struct nvkm_fb *fb = device->fb;
 	struct nvkm_tags *tags;
 
-	mutex_lock(&fb->subdev.mutex);
-	if ((tags = memory->tags)) {
+	/* Additional mappings of memory that already has comptags don't
+	 * need to take any locks, the last reference is only dropped (and
+	 * memory->tags cleared) under the FB mutex.
+	 */
+	rcu_read_lock();
+	tags = rcu_dereference(memory->tags);
+	if (tags && !refcount_inc_not_zero(&tags->refcount))
+		tags = NULL;
+	rcu_read_unlock();
+
+	if (tags) {
 		/* If comptags exist for the memory, but a different amount
 		 * than requested, the buffer is being mapped with settings
 		 * that are incompatible with existing mappings.
 		 */
-		if (tags->mn && tags->mn->length != nr) {
+		if (tags->nr && tags->nr != nr) {
+			nvkm_memory_tags_put(memory, device, &tags);
+			return -EINVAL;
+		}
+
+		*ptags = tags;
+		return 0;
+	}
+
+	mutex_lock(&fb->subdev.mutex);
+	if ((tags = memory->tags)) {
+		if (tags->nr && tags->nr != nr) {
 			mutex_unlock(&fb->subdev.mutex);
 			return -EINVAL;
 		}
@@ -69,14 +166,19 @@ nvkm_memory_tags_get(struct nvkm_memory *memory, struct nvkm_device *device,
 		return 0;
 	}
 
-	if (!(tags = kmalloc(sizeof(*tags), GFP_KERNEL))) {
+	if (!(tags = kzalloc(sizeof(*tags), GFP_KERNEL))) {
 		mutex_unlock(&fb->subdev.mutex);
 		return -ENOMEM;
 	}
 
-	if (!nvkm_mm_head(&fb->tags, 0, 1, nr, nr, 1, &tags->mn)) {
+	if (!nvkm_fb_tags_get(fb, nr, &tags->offset)) {
+		/* The clear is only issued here, it's waited on by the VMM
+		 * before the mapping is handed back to its user.  This does
+		 * wait for any earlier clear, see nvkm_ltc_tags_clear().
+		 */
+		tags->nr = nr;
 		if (clr)
-			clr(device, tags->mn->offset, tags->mn->length);
+			tags->clear = clr(device, tags->offset, tags->nr);
 	} else {
 		/* Failure to allocate HW comptags is not an error, the
 		 * caller should fall back to an uncompressed map.
@@ -87,10 +189,11 @@ nvkm_memory_tags_get(struct nvkm_memory *memory, struct nvkm_device *device,
 		 *
 		 * This is handled by returning an empty nvkm_tags.
 		 */
-		tags->mn = NULL;
+		tags->nr = 0;
 	}
 
 	refcount_set(&tags->refcount, 1);
+	rcu_assign_pointer(memory->tags, tags);
 	mutex_unlock(&fb->subdev.mutex);
 	*ptags = tags;
 	return 0;
@@ -91,6 +91,17 @@ nvkm_subdev_intr(struct nvkm_subdev *subdev)
 		subdev->func->intr(subdev);
 }
 
+bool
+nvkm_subdev_stat(struct nvkm_subdev *subdev, int index,
+		 struct nvkm_subdev_stat *stat)
+{
+	stat->index = index;
+	stat->name = NULL;
+	if (subdev->func->stat)
+		subdev->func->stat(subdev, stat);
+	return stat->name != NULL;
+}
+
 int
 nvkm_subdev_fini(struct nvkm_subdev *subdev, bool suspend)
 {
@@ -113,6 +124,10 @@ nvkm_subdev_fini(struct nvkm_subdev *subdev, bool suspend)
 	nvkm_mc_reset(device, subdev->index);
 
 	time = ktime_to_us(ktime_get()) - time;
+	if (suspend)
+		subdev->time.suspend = time;
+	else
+		subdev->time.fini = time;
 	nvkm_trace(subdev, "%s completed in %lldus\n", action, time);
 	return 0;
 }
@@ -134,6 +149,7 @@ nvkm_subdev_preinit(struct nvkm_subdev *subdev)
 	}
 
 	time = ktime_to_us(ktime_get()) - time;
+	subdev->time.preinit = time;
 	nvkm_trace(subdev, "preinit completed in %lldus\n", time);
 	return 0;
 }
@@ -159,6 +175,7 @@ nvkm_subdev_init(struct nvkm_subdev *subdev)
 
 		subdev->oneinit = true;
 		time = ktime_to_us(ktime_get()) - time;
+		subdev->time.oneinit = time;
 		nvkm_trace(subdev, "one-time init completed in %lldus\n", time);
 	}
 
@@ -171,6 +188,7 @@ nvkm_subdev_init(struct nvkm_subdev *subdev)
 	}
 
 	time = ktime_to_us(ktime_get()) - time;
+	subdev->time.init = time;
 	nvkm_trace(subdev, "init completed in %lldus\n", time);
 	return 0;
 }
@@ -2518,6 +2518,10 @@ nvkm_device_fini(struct nvkm_device *device, bool suspend)
 		device->func->fini(device, suspend);
 
 	time = ktime_to_us(ktime_get()) - time;
+	if (suspend)
+		device->time.suspend = time;
+	else
+		device->time.fini = time;
 	nvdev_trace(device, "%s completed in %lldus...\n", action, time);
 	return 0;
 
@@ -2539,7 +2543,7 @@ nvkm_device_preinit(struct nvkm_device *device)
 {
 	struct nvkm_subdev *subdev;
 	int ret, i;
-	s64 time;
+	s64 time, post;
 
 	nvdev_trace(device, "preinit running...\n");
 	time = ktime_to_us(ktime_get());
@@ -2558,11 +2562,14 @@ nvkm_device_preinit(struct nvkm_device *device)
 		}
 	}
 
+	post = ktime_to_us(ktime_get());
 	ret = nvkm_devinit_post(device->devinit, &device->disable_mask);
 	if (ret)
 		goto fail;
+	device->time.post = ktime_to_us(ktime_get()) - post;
 
 	time = ktime_to_us(ktime_get()) - time;
+	device->time.preinit = time;
 	nvdev_trace(device, "preinit completed in %lldus\n", time);
 	return 0;
 
@@ -2604,6 +2611,7 @@ nvkm_device_init(struct nvkm_device *device)
 	nvkm_acpi_init(device);
 
 	time = ktime_to_us(ktime_get()) - time;
+	device->time.init = time;
 	nvdev_trace(device, "init completed in %lldus\n", time);
 	return 0;
 
@@ -24,6 +24,7 @@
 #include "ctrl.h"
 
 #include <core/client.h>
+#include <core/subdev.h>
 #include <subdev/clk.h>
 
 #include <nvif/class.h>
@@ -166,6 +167,127 @@ nvkm_control_mthd_pstate_user(struct nvkm_control *ctrl, void *data, u32 size)
 	return ret;
 }
 
+static int
+nvkm_control_mthd_time_info(struct nvkm_control *ctrl, void *data, u32 size)
+{
+	union {
+		struct nvif_control_time_info_v0 v0;
+	} *args = data;
+	struct nvkm_device *device = ctrl->device;
+	int ret = -ENOSYS;
+
+	nvif_ioctl(&ctrl->object, "control time info size %d\n", size);
+	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
+		nvif_ioctl(&ctrl->object, "control time info vers %d\n",
+			   args->v0.version);
+	} else
+		return ret;
+
+	args->v0.preinit = device->time.preinit;
+	args->v0.post = device->time.post;
+	args->v0.init = device->time.init;
+	args->v0.fini = device->time.fini;
+	args->v0.suspend = device->time.suspend;
+	return 0;
+}
+
+static int
+nvkm_control_mthd_time_attr(struct nvkm_control *ctrl, void *data, u32 size)
+{
+	union {
+		struct nvif_control_time_attr_v0 v0;
+	} *args = data;
+	struct nvkm_device *device = ctrl->device;
+	struct nvkm_subdev *subdev = NULL;
+	int i, ret = -ENOSYS;
+
+	nvif_ioctl(&ctrl->object, "control time attr size %d\n", size);
+	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
+		nvif_ioctl(&ctrl->object, "control time attr vers %d index %d\n",
+			   args->v0.version, args->v0.index);
+	} else
+		return ret;
+
+	for (i = args->v0.index; i < NVKM_SUBDEV_NR; i++) {
+		if ((subdev = nvkm_device_subdev(device, i)))
+			break;
+	}
+
+	if (!subdev)
+		return -ENODEV;
+
+	snprintf(args->v0.name, sizeof(args->v0.name), "%s",
+		 nvkm_subdev_name[subdev->index]);
+	args->v0.preinit = subdev->time.preinit;
+	args->v0.oneinit = subdev->time.oneinit;
+	args->v0.init = subdev->time.init;
+	args->v0.fini = subdev->time.fini;
+	args->v0.suspend = subdev->time.suspend;
+
+	args->v0.index = 0;
+	while (++i < NVKM_SUBDEV_NR) {
+		if (nvkm_device_subdev(device, i)) {
+			args->v0.index = i;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* Finds the first counter at or after index of subdev, if any. */
+static struct nvkm_subdev *
+nvkm_control_stat_find(struct nvkm_device *device, int *subdev, int *index,
+		       struct nvkm_subdev_stat *stat)
+{
+	struct nvkm_subdev *temp;
+
+	for (; *subdev < NVKM_SUBDEV_NR; (*subdev)++, *index = 0) {
+		temp = nvkm_device_subdev(device, *subdev);
+		if (temp && nvkm_subdev_stat(temp, *index, stat))
+			return temp;
+	}
+
+	return NULL;
+}
+
+static int
+nvkm_control_mthd_stat_attr(struct nvkm_control *ctrl, void *data, u32 size)
+{
+	union {
+		struct nvif_control_stat_attr_v0 v0;
+	} *args = data;
+	struct nvkm_device *device = ctrl->device;
+	struct nvkm_subdev_stat stat, next;
+	struct nvkm_subdev *subdev;
+	int i, j, ret = -ENOSYS;
+
+	nvif_ioctl(&ctrl->object, "control stat attr size %d\n", size);
+	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
+		nvif_ioctl(&ctrl->object, "control stat attr vers %d "
+					  "subdev %d index %d\n",
+			   args->v0.version, args->v0.subdev, args->v0.index);
+	} else
+		return ret;
+
+	i = args->v0.subdev;
+	j = args->v0.index;
+	if (!(subdev = nvkm_control_stat_find(device, &i, &j, &stat)))
+		return -ENODEV;
+
+	snprintf(args->v0.owner, sizeof(args->v0.owner), "%s",
+		 nvkm_subdev_name[subdev->index]);
+	snprintf(args->v0.name, sizeof(args->v0.name), "%s", stat.name);
+	args->v0.value = stat.value;
+
+	j++;
+	if (!nvkm_control_stat_find(device, &i, &j, &next))
+		i = j = 0;
+	args->v0.subdev = i;
+	args->v0.index = j;
+	return 0;
+}
+
 static int
 nvkm_control_mthd(struct nvkm_object *object, u32 mthd, void *data, u32 size)
 {
@@ -177,6 +299,12 @@ nvkm_control_mthd(struct nvkm_object *object, u32 mthd, void *data, u32 size)
 		return nvkm_control_mthd_pstate_attr(ctrl, data, size);
 	case NVIF_CONTROL_PSTATE_USER:
 		return nvkm_control_mthd_pstate_user(ctrl, data, size);
+	case NVIF_CONTROL_TIME_INFO:
+		return nvkm_control_mthd_time_info(ctrl, data, size);
+	case NVIF_CONTROL_TIME_ATTR:
+		return nvkm_control_mthd_time_attr(ctrl, data, size);
+	case NVIF_CONTROL_STAT_ATTR:
+		return nvkm_control_mthd_stat_attr(ctrl, data, size);
 	default:
 		break;
 	}
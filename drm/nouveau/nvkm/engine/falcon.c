@@ -22,6 +22,7 @@
 #include <engine/falcon.h>
 
 #include <core/gpuobj.h>
+#include <subdev/instmem.h>
 #include <subdev/timer.h>
 #include <engine/fifo.h>
 
@@ -250,9 +251,15 @@ nvkm_falcon_init(struct nvkm_engine *engine)
 			return ret;
 		}
 
+		/* image is re-uploaded on every init, don't preserve it */
+		nvkm_instobj_preserve(device->imem, falcon->core,
+				      NVKM_INSTOBJ_DISCARD);
+	}
+
+	if (falcon->core) {
 		nvkm_kmap(falcon->core);
-		for (i = 0; i < falcon->code.size; i += 4)
-			nvkm_wo32(falcon->core, i, falcon->code.data[i / 4]);
+		nvkm_memory_copy_to(falcon->core, 0, falcon->code.data,
+				    falcon->code.size);
 		nvkm_done(falcon->core);
 	}
 
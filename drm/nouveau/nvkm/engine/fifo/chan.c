@@ -333,7 +333,11 @@ nvkm_fifo_chan_dtor(struct nvkm_object *object)
 	}
 
 	nvkm_gpuobj_del(&chan->push);
-	nvkm_gpuobj_del(&chan->inst);
+	if (chan->inst) {
+		nvkm_client_charge(chan->object.client, NVKM_CLIENT_MEM_CHAN,
+				   -(s64)chan->inst->size);
+		nvkm_gpuobj_del(&chan->inst);
+	}
 	return data;
 }
 
@@ -373,6 +377,8 @@ nvkm_fifo_chan_ctor(const struct nvkm_fifo_chan_func *func,
 	if (ret)
 		return ret;
 
+	nvkm_client_charge(client, NVKM_CLIENT_MEM_CHAN, chan->inst->size);
+
 	/* allocate push buffer ctxdma instance */
 	if (push) {
 		dmaobj = nvkm_dmaobj_search(client, push);
@@ -27,6 +27,7 @@
 #include <core/client.h>
 #include <core/gpuobj.h>
 #include <subdev/bar.h>
+#include <subdev/mmu.h>
 #include <subdev/timer.h>
 #include <subdev/top.h>
 #include <engine/sw.h>
@@ -462,9 +463,11 @@ gk104_fifo_intr_fault(struct gk104_fifo *fifo, int unit)
 	u32 write  = (stat & 0x00000080);
 	u32 hub    = (stat & 0x00000040);
 	u32 reason = (stat & 0x0000000f);
+	u64 addr = (u64)vahi << 32 | valo;
 	const struct nvkm_enum *er, *eu, *ec;
 	struct nvkm_engine *engine = NULL;
 	struct nvkm_fifo_chan *chan;
+	struct nvkm_vma_info vma;
 	unsigned long flags;
 	char gpcid[8] = "", en[16] = "";
 	int engn;
@@ -515,12 +518,20 @@ gk104_fifo_intr_fault(struct gk104_fifo *fifo, int unit)
 	nvkm_error(subdev,
 		   "%s fault at %010llx engine %02x [%s] client %02x [%s%s] "
 		   "reason %02x [%s] on channel %d [%010llx %s]\n",
-		   write ? "write" : "read", (u64)vahi << 32 | valo,
+		   write ? "write" : "read", addr,
 		   unit, en, client, gpcid, ec ? ec->name : "",
 		   reason, er ? er->name : "", chan ? chan->chid : -1,
 		   (u64)inst << 12,
 		   chan ? chan->object.client->name : "unknown");
 
+	/* We can't take vmm->mutex here, but a lockless lookup is fine. */
+	if (chan && chan->vmm && !nvkm_vmm_node_lookup(chan->vmm, addr, &vma)) {
+		nvkm_error(subdev, "fault address within vma %010llx-%010llx "
+				   "[%s%s%s]\n", vma.addr, vma.addr + vma.size,
+			   vma.mapped ? "mapped" : "unmapped",
+			   vma.sparse ? ", sparse" : "",
+			   vma.user ? ", user" : "");
+	}
 
 	/* Kill the channel that caused the fault. */
 	if (chan)
@@ -302,8 +302,7 @@ gk104_fifo_gpfifo_new_(const struct gk104_fifo_chan_func *func,
 	ilength = order_base_2(ilength / 8);
 
 	nvkm_kmap(fifo->user.mem);
-	for (i = 0; i < 0x200; i += 4)
-		nvkm_wo32(fifo->user.mem, usermem + i, 0x00000000);
+	nvkm_memory_fill(fifo->user.mem, usermem, 0x00000000, 0x200);
 	nvkm_done(fifo->user.mem);
 	usermem = nvkm_memory_addr(fifo->user.mem) + usermem;
 
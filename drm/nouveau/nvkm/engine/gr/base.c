@@ -99,6 +99,14 @@ nvkm_gr_intr(struct nvkm_engine *engine)
 	gr->func->intr(gr);
 }
 
+static void
+nvkm_gr_stat(struct nvkm_engine *engine, struct nvkm_subdev_stat *stat)
+{
+	struct nvkm_gr *gr = nvkm_gr(engine);
+	if (gr->func->stat)
+		gr->func->stat(gr, stat);
+}
+
 static int
 nvkm_gr_oneinit(struct nvkm_engine *engine)
 {
@@ -142,6 +150,7 @@ nvkm_gr = {
 	.intr = nvkm_gr_intr,
 	.tile = nvkm_gr_tile,
 	.chsw_load = nvkm_gr_chsw_load,
+	.stat = nvkm_gr_stat,
 	.fifo.cclass = nvkm_gr_cclass_new,
 	.fifo.sclass = nvkm_gr_oclass_get,
 };
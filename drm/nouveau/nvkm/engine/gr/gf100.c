@@ -59,6 +59,7 @@ gf100_gr_zbc_clear_color(struct gf100_gr *gr, int zbc)
 	nvkm_wr32(device, 0x405824, 0x00000004); /* TRIGGER | WRITE | COLOR */
 }
 
+/* Must be called with zbc.mutex held. */
 static int
 gf100_gr_zbc_color_get(struct gf100_gr *gr, int format,
 		       const u32 ds[4], const u32 l2[4])
@@ -78,18 +79,22 @@ gf100_gr_zbc_color_get(struct gf100_gr *gr, int format,
 				WARN_ON(1);
 				return -EINVAL;
 			}
+			gr->zbc.hits++;
 			return i;
 		} else {
 			zbc = (zbc < 0) ? i : zbc;
 		}
 	}
 
-	if (zbc < 0)
+	if (zbc < 0) {
+		gr->zbc.fallbacks++;
 		return zbc;
+	}
 
 	memcpy(gr->zbc_color[zbc].ds, ds, sizeof(gr->zbc_color[zbc].ds));
 	memcpy(gr->zbc_color[zbc].l2, l2, sizeof(gr->zbc_color[zbc].l2));
 	gr->zbc_color[zbc].format = format;
+	gr->zbc.misses++;
 	nvkm_ltc_zbc_color_get(ltc, zbc, l2);
 	gf100_gr_zbc_clear_color(gr, zbc);
 	return zbc;
@@ -106,6 +111,7 @@ gf100_gr_zbc_clear_depth(struct gf100_gr *gr, int zbc)
 	nvkm_wr32(device, 0x405824, 0x00000005); /* TRIGGER | WRITE | DEPTH */
 }
 
+/* Must be called with zbc.mutex held. */
 static int
 gf100_gr_zbc_depth_get(struct gf100_gr *gr, int format,
 		       const u32 ds, const u32 l2)
@@ -123,18 +129,22 @@ gf100_gr_zbc_depth_get(struct gf100_gr *gr, int format,
 				WARN_ON(1);
 				return -EINVAL;
 			}
+			gr->zbc.hits++;
 			return i;
 		} else {
 			zbc = (zbc < 0) ? i : zbc;
 		}
 	}
 
-	if (zbc < 0)
+	if (zbc < 0) {
+		gr->zbc.fallbacks++;
 		return zbc;
+	}
 
 	gr->zbc_depth[zbc].format = format;
 	gr->zbc_depth[zbc].ds = ds;
 	gr->zbc_depth[zbc].l2 = l2;
+	gr->zbc.misses++;
 	nvkm_ltc_zbc_depth_get(ltc, zbc, l2);
 	gf100_gr_zbc_clear_depth(gr, zbc);
 	return zbc;
@@ -180,9 +190,11 @@ gf100_fermi_mthd_zbc_color(struct nvkm_object *object, void *data, u32 size)
 		case FERMI_A_ZBC_COLOR_V0_FMT_AU8BU8GU8RU8:
 		case FERMI_A_ZBC_COLOR_V0_FMT_A2R10G10B10:
 		case FERMI_A_ZBC_COLOR_V0_FMT_BF10GF11RF11:
+			mutex_lock(&gr->zbc.mutex);
 			ret = gf100_gr_zbc_color_get(gr, args->v0.format,
 							   args->v0.ds,
 							   args->v0.l2);
+			mutex_unlock(&gr->zbc.mutex);
 			if (ret >= 0) {
 				args->v0.index = ret;
 				return 0;
@@ -208,9 +220,11 @@ gf100_fermi_mthd_zbc_depth(struct nvkm_object *object, void *data, u32 size)
 	if (!(ret = nvif_unpack(ret, &data, &size, args->v0, 0, 0, false))) {
 		switch (args->v0.format) {
 		case FERMI_A_ZBC_DEPTH_V0_FMT_FP32:
+			mutex_lock(&gr->zbc.mutex);
 			ret = gf100_gr_zbc_depth_get(gr, args->v0.format,
 							   args->v0.ds,
 							   args->v0.l2);
+			mutex_unlock(&gr->zbc.mutex);
 			return (ret >= 0) ? 0 : -ENOSPC;
 		default:
 			return -EINVAL;
@@ -309,22 +323,30 @@ gf100_gr_object_get(struct nvkm_gr *base, int index, struct nvkm_sclass *sclass)
  * PGRAPH context
  ******************************************************************************/
 
+static void
+gf100_gr_chan_charge(struct gf100_gr_chan *chan, u32 size)
+{
+	nvkm_client_charge(chan->object.client, NVKM_CLIENT_MEM_CHAN, size);
+	chan->size += size;
+}
+
 static int
 gf100_gr_chan_bind(struct nvkm_object *object, struct nvkm_gpuobj *parent,
 		   int align, struct nvkm_gpuobj **pgpuobj)
 {
 	struct gf100_gr_chan *chan = gf100_gr_chan(object);
 	struct gf100_gr *gr = chan->gr;
-	int ret, i;
+	int ret;
 
 	ret = nvkm_gpuobj_new(gr->base.engine.subdev.device, gr->size,
 			      align, false, parent, pgpuobj);
 	if (ret)
 		return ret;
 
+	gf100_gr_chan_charge(chan, (*pgpuobj)->size);
+
 	nvkm_kmap(*pgpuobj);
-	for (i = 0; i < gr->size; i += 4)
-		nvkm_wo32(*pgpuobj, i, gr->data[i / 4]);
+	nvkm_gpuobj_memcpy_to(*pgpuobj, 0, gr->data, gr->size);
 
 	if (!gr->firmware) {
 		nvkm_wo32(*pgpuobj, 0x00, chan->mmio_nr / 2);
@@ -358,6 +380,9 @@ gf100_gr_chan_dtor(struct nvkm_object *object)
 	nvkm_vmm_put(chan->vmm, &chan->mmio_vma);
 	nvkm_memory_unref(&chan->mmio);
 	nvkm_vmm_unref(&chan->vmm);
+
+	nvkm_client_charge(chan->object.client, NVKM_CLIENT_MEM_CHAN,
+			   -(s64)chan->size);
 	return chan;
 }
 
@@ -396,6 +421,8 @@ gf100_gr_chan_new(struct nvkm_gr *base, struct nvkm_fifo_chan *fifoch,
 	if (ret)
 		return ret;
 
+	gf100_gr_chan_charge(chan, nvkm_memory_size(chan->mmio));
+
 	ret = nvkm_vmm_get(fifoch->vmm, 12, 0x1000, &chan->mmio_vma);
 	if (ret)
 		return ret;
@@ -413,6 +440,8 @@ gf100_gr_chan_new(struct nvkm_gr *base, struct nvkm_fifo_chan *fifoch,
 		if (ret)
 			return ret;
 
+		gf100_gr_chan_charge(chan, nvkm_memory_size(chan->data[i].mem));
+
 		ret = nvkm_vmm_get(fifoch->vmm, 12,
 				   nvkm_memory_size(chan->data[i].mem),
 				   &chan->data[i].vma);
@@ -745,6 +774,7 @@ gf100_gr_zbc_init(struct gf100_gr *gr)
 	struct nvkm_ltc *ltc = gr->base.engine.subdev.device->ltc;
 	int index;
 
+	mutex_lock(&gr->zbc.mutex);
 	if (!gr->zbc_color[0].format) {
 		gf100_gr_zbc_color_get(gr, 1,  & zero[0],   &zero[4]);
 		gf100_gr_zbc_color_get(gr, 2,  &  one[0],    &one[4]);
@@ -758,6 +788,7 @@ gf100_gr_zbc_init(struct gf100_gr *gr)
 		gf100_gr_zbc_clear_color(gr, index);
 	for (index = ltc->zbc_min; index <= ltc->zbc_max; index++)
 		gf100_gr_zbc_clear_depth(gr, index);
+	mutex_unlock(&gr->zbc.mutex);
 }
 
 /**
@@ -1769,11 +1800,24 @@ gf100_gr_dtor_init(struct gf100_gr_pack *pack)
 	vfree(pack);
 }
 
+static void
+gf100_gr_stat(struct nvkm_gr *base, struct nvkm_subdev_stat *stat)
+{
+	struct gf100_gr *gr = gf100_gr(base);
+	nvkm_stat(stat, "zbc hits", gr->zbc.hits);
+	nvkm_stat(stat, "zbc misses", gr->zbc.misses);
+	nvkm_stat(stat, "zbc fallbacks", gr->zbc.fallbacks);
+}
+
 void *
 gf100_gr_dtor(struct nvkm_gr *base)
 {
 	struct gf100_gr *gr = gf100_gr(base);
 
+	nvkm_debug(&gr->base.engine.subdev,
+		   "zbc: %llu hits, %llu misses, %llu fallbacks\n",
+		   gr->zbc.hits, gr->zbc.misses, gr->zbc.fallbacks);
+
 	if (gr->func->dtor)
 		gr->func->dtor(gr);
 	kfree(gr->data);
@@ -1805,6 +1849,7 @@ gf100_gr_ = {
 	.chan_new = gf100_gr_chan_new,
 	.object_get = gf100_gr_object_get,
 	.chsw_load = gf100_gr_chsw_load,
+	.stat = gf100_gr_stat,
 };
 
 int
@@ -1879,6 +1924,7 @@ gf100_gr_ctor(const struct gf100_gr_func *func, struct nvkm_device *device,
 	      int index, struct gf100_gr *gr)
 {
 	gr->func = func;
+	mutex_init(&gr->zbc.mutex);
 	gr->firmware = nvkm_boolopt(device->cfgopt, "NvGrUseFW",
 				    func->fecs.ucode == NULL);
 
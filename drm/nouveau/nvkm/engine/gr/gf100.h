@@ -95,6 +95,12 @@ struct gf100_gr {
 
 	struct gf100_gr_zbc_color zbc_color[NVKM_LTC_MAX_ZBC_CNT];
 	struct gf100_gr_zbc_depth zbc_depth[NVKM_LTC_MAX_ZBC_CNT];
+	struct {
+		struct mutex mutex; /* protects zbc_color/zbc_depth */
+		u64 hits; /* Lookups that matched an existing entry. */
+		u64 misses; /* Lookups that programmed a new entry. */
+		u64 fallbacks; /* Lookups that failed, table full. */
+	} zbc;
 
 	u8 rop_nr;
 	u8 gpc_nr;
@@ -171,6 +177,8 @@ struct gf100_gr_chan {
 		struct nvkm_memory *mem;
 		struct nvkm_vma *vma;
 	} data[4];
+
+	u32 size; /* Charged to the client. */
 };
 
 void gf100_gr_ctxctl_debug(struct gf100_gr *);
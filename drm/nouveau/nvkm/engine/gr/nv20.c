@@ -59,7 +59,11 @@ void *
 nv20_gr_chan_dtor(struct nvkm_object *object)
 {
 	struct nv20_gr_chan *chan = nv20_gr_chan(object);
-	nvkm_memory_unref(&chan->inst);
+	if (chan->inst) {
+		nvkm_client_charge(object->client, NVKM_CLIENT_MEM_CHAN,
+				   -(s64)nvkm_memory_size(chan->inst));
+		nvkm_memory_unref(&chan->inst);
+	}
 	return chan;
 }
 
@@ -91,6 +95,9 @@ nv20_gr_chan_new(struct nvkm_gr *base, struct nvkm_fifo_chan *fifoch,
 	if (ret)
 		return ret;
 
+	nvkm_client_charge(chan->object.client, NVKM_CLIENT_MEM_CHAN,
+			   nvkm_memory_size(chan->inst));
+
 	nvkm_kmap(chan->inst);
 	nvkm_wo32(chan->inst, 0x0000, 0x00000001 | (chan->chid << 24));
 	nvkm_wo32(chan->inst, 0x033c, 0xffff0000);
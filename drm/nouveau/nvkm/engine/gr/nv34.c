@@ -1,6 +1,7 @@
 #include "nv20.h"
 #include "regs.h"
 
+#include <core/client.h>
 #include <core/gpuobj.h>
 #include <engine/fifo.h>
 #include <engine/fifo/chan.h>
@@ -37,6 +38,9 @@ nv34_gr_chan_new(struct nvkm_gr *base, struct nvkm_fifo_chan *fifoch,
 	if (ret)
 		return ret;
 
+	nvkm_client_charge(chan->object.client, NVKM_CLIENT_MEM_CHAN,
+			   nvkm_memory_size(chan->inst));
+
 	nvkm_kmap(chan->inst);
 	nvkm_wo32(chan->inst, 0x0028, 0x00000001 | (chan->chid << 24));
 	nvkm_wo32(chan->inst, 0x040c, 0x01000101);
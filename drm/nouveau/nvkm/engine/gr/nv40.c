@@ -79,6 +79,9 @@ nv40_gr_chan_bind(struct nvkm_object *object, struct nvkm_gpuobj *parent,
 	int ret = nvkm_gpuobj_new(gr->base.engine.subdev.device, gr->size,
 				  align, true, parent, pgpuobj);
 	if (ret == 0) {
+		chan->size = (*pgpuobj)->size;
+		nvkm_client_charge(object->client, NVKM_CLIENT_MEM_CHAN,
+				   chan->size);
 		chan->inst = (*pgpuobj)->addr;
 		nvkm_kmap(*pgpuobj);
 		nv40_grctx_fill(gr->base.engine.subdev.device, *pgpuobj);
@@ -134,6 +137,8 @@ nv40_gr_chan_dtor(struct nvkm_object *object)
 	spin_lock_irqsave(&chan->gr->base.engine.lock, flags);
 	list_del(&chan->head);
 	spin_unlock_irqrestore(&chan->gr->base.engine.lock, flags);
+	nvkm_client_charge(object->client, NVKM_CLIENT_MEM_CHAN,
+			   -(s64)chan->size);
 	return chan;
 }
 
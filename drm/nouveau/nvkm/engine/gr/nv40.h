@@ -24,6 +24,7 @@ struct nv40_gr_chan {
 	struct nvkm_fifo_chan *fifo;
 	u32 inst;
 	struct list_head head;
+	u32 size; /* Charged to the client. */
 };
 
 int nv40_gr_chan_new(struct nvkm_gr *, struct nvkm_fifo_chan *,
@@ -69,10 +69,14 @@ static int
 nv50_gr_chan_bind(struct nvkm_object *object, struct nvkm_gpuobj *parent,
 		  int align, struct nvkm_gpuobj **pgpuobj)
 {
-	struct nv50_gr *gr = nv50_gr_chan(object)->gr;
+	struct nv50_gr_chan *chan = nv50_gr_chan(object);
+	struct nv50_gr *gr = chan->gr;
 	int ret = nvkm_gpuobj_new(gr->base.engine.subdev.device, gr->size,
 				  align, true, parent, pgpuobj);
 	if (ret == 0) {
+		chan->size = (*pgpuobj)->size;
+		nvkm_client_charge(object->client, NVKM_CLIENT_MEM_CHAN,
+				   chan->size);
 		nvkm_kmap(*pgpuobj);
 		nv50_grctx_fill(gr->base.engine.subdev.device, *pgpuobj);
 		nvkm_done(*pgpuobj);
@@ -80,8 +84,18 @@ nv50_gr_chan_bind(struct nvkm_object *object, struct nvkm_gpuobj *parent,
 	return ret;
 }
 
+static void *
+nv50_gr_chan_dtor(struct nvkm_object *object)
+{
+	struct nv50_gr_chan *chan = nv50_gr_chan(object);
+	nvkm_client_charge(object->client, NVKM_CLIENT_MEM_CHAN,
+			   -(s64)chan->size);
+	return chan;
+}
+
 static const struct nvkm_object_func
 nv50_gr_chan = {
+	.dtor = nv50_gr_chan_dtor,
 	.bind = nv50_gr_chan_bind,
 };
 
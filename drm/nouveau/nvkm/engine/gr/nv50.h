@@ -24,6 +24,7 @@ int g84_gr_tlb_flush(struct nvkm_gr *);
 struct nv50_gr_chan {
 	struct nvkm_object object;
 	struct nv50_gr *gr;
+	u32 size; /* Charged to the client. */
 };
 
 int nv50_gr_chan_new(struct nvkm_gr *, struct nvkm_fifo_chan *,
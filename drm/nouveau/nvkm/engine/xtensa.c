@@ -22,6 +22,7 @@
 #include <engine/xtensa.h>
 
 #include <core/gpuobj.h>
+#include <subdev/instmem.h>
 #include <engine/fifo.h>
 
 static int
@@ -99,7 +100,7 @@ nvkm_xtensa_init(struct nvkm_engine *engine)
 	const u32 base = xtensa->addr;
 	const struct firmware *fw;
 	char name[32];
-	int i, ret;
+	int ret;
 	u64 addr, size;
 	u32 tmp;
 
@@ -128,10 +129,13 @@ nvkm_xtensa_init(struct nvkm_engine *engine)
 		}
 
 		nvkm_kmap(xtensa->gpu_fw);
-		for (i = 0; i < fw->size / 4; i++)
-			nvkm_wo32(xtensa->gpu_fw, i * 4, *((u32 *)fw->data + i));
+		nvkm_memory_copy_to(xtensa->gpu_fw, 0, fw->data, fw->size);
 		nvkm_done(xtensa->gpu_fw);
 		release_firmware(fw);
+
+		/* image is never modified, only save it once */
+		nvkm_instobj_preserve(device->imem, xtensa->gpu_fw,
+				      NVKM_INSTOBJ_CONST);
 	}
 
 	addr = nvkm_memory_addr(xtensa->gpu_fw);
@@ -23,6 +23,8 @@
  */
 #include "priv.h"
 
+#include <subdev/instmem.h>
+
 void
 nvkm_bar_flush(struct nvkm_bar *bar)
 {
@@ -100,6 +102,7 @@ static void *
 nvkm_bar_dtor(struct nvkm_subdev *subdev)
 {
 	struct nvkm_bar *bar = nvkm_bar(subdev);
+	nvkm_instmem_bar2_fini(subdev->device->imem);
 	nvkm_bar_bar2_fini(subdev->device);
 	return bar->func->dtor(bar);
 }
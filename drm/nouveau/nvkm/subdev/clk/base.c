@@ -269,8 +269,11 @@ nvkm_pstate_prog(struct nvkm_clk *clk, int pstatei)
 	struct nvkm_fb *fb = subdev->device->fb;
 	struct nvkm_pci *pci = subdev->device->pci;
 	struct nvkm_pstate *pstate;
+	s64 time, mem = 0;
 	int ret, idx = 0;
 
+	time = ktime_to_us(ktime_get());
+
 	list_for_each_entry(pstate, &clk->states, head) {
 		if (idx++ == pstatei)
 			break;
@@ -284,15 +287,21 @@ nvkm_pstate_prog(struct nvkm_clk *clk, int pstatei)
 	if (fb && fb->ram && fb->ram->func->calc) {
 		struct nvkm_ram *ram = fb->ram;
 		int khz = pstate->base.domain[nv_clk_src_mem];
+		mem = ktime_to_us(ktime_get());
 		do {
 			ret = ram->func->calc(ram, khz);
 			if (ret == 0)
 				ret = ram->func->prog(ram);
 		} while (ret > 0);
 		ram->func->tidy(ram);
+		mem = ktime_to_us(ktime_get()) - mem;
 	}
 
-	return nvkm_cstate_prog(clk, pstate, NVKM_CLK_CSTATE_HIGHEST);
+	ret = nvkm_cstate_prog(clk, pstate, NVKM_CLK_CSTATE_HIGHEST);
+	time = ktime_to_us(ktime_get()) - time;
+	nvkm_debug(subdev, "performance state %d took %lldus, memory %lldus\n",
+		   pstatei, time, mem);
+	return ret;
 }
 
 static void
@@ -542,9 +551,14 @@ nvkm_clk_astate(struct nvkm_clk *clk, int req, int rel, bool wait)
 int
 nvkm_clk_tstate(struct nvkm_clk *clk, u8 temp)
 {
+	struct nvkm_fb *fb = clk->subdev.device->fb;
+
 	if (clk->temp == temp)
 		return 0;
 	clk->temp = temp;
+
+	if (fb && fb->ram)
+		nvkm_ram_script_flush(fb->ram);
 	return nvkm_pstate_calc(clk, false);
 }
 
@@ -95,9 +95,10 @@ nvkm_fb_oneinit(struct nvkm_subdev *subdev)
 {
 	struct nvkm_fb *fb = nvkm_fb(subdev);
 	u32 tags = 0;
+	int ret;
 
 	if (fb->func->ram_new) {
-		int ret = fb->func->ram_new(fb, &fb->ram);
+		ret = fb->func->ram_new(fb, &fb->ram);
 		if (ret) {
 			nvkm_error(subdev, "vram setup failed, %d\n", ret);
 			return ret;
@@ -105,7 +106,7 @@ nvkm_fb_oneinit(struct nvkm_subdev *subdev)
 	}
 
 	if (fb->func->oneinit) {
-		int ret = fb->func->oneinit(fb);
+		ret = fb->func->oneinit(fb);
 		if (ret)
 			return ret;
 	}
@@ -119,6 +120,10 @@ nvkm_fb_oneinit(struct nvkm_subdev *subdev)
 		nvkm_debug(subdev, "%d comptags\n", tags);
 	}
 
+	ret = nvkm_fb_tags_init(fb, tags);
+	if (ret)
+		return ret;
+
 	return nvkm_mm_init(&fb->tags, 0, 0, tags, 1);
 }
 
@@ -129,6 +134,8 @@ nvkm_fb_init(struct nvkm_subdev *subdev)
 	int ret, i;
 
 	if (fb->ram) {
+		/* Hardware state may not match what scripts were built for. */
+		nvkm_ram_script_flush(fb->ram);
 		ret = nvkm_ram_init(fb->ram);
 		if (ret)
 			return ret;
@@ -151,6 +158,16 @@ nvkm_fb_init(struct nvkm_subdev *subdev)
 	return 0;
 }
 
+static void
+nvkm_fb_stat(struct nvkm_subdev *subdev, struct nvkm_subdev_stat *stat)
+{
+	struct nvkm_fb *fb = nvkm_fb(subdev);
+	nvkm_stat(stat, "comptags", fb->comptags.nr);
+	nvkm_stat(stat, "comptags allocated", READ_ONCE(fb->comptags.busy));
+	if (fb->ram)
+		nvkm_ram_stat(fb->ram, stat);
+}
+
 static void *
 nvkm_fb_dtor(struct nvkm_subdev *subdev)
 {
@@ -164,6 +181,7 @@ nvkm_fb_dtor(struct nvkm_subdev *subdev)
 		fb->func->tile.fini(fb, i, &fb->tile.region[i]);
 
 	nvkm_mm_fini(&fb->tags);
+	nvkm_fb_tags_fini(fb);
 	nvkm_ram_del(&fb->ram);
 
 	if (fb->func->dtor)
@@ -177,6 +195,7 @@ nvkm_fb = {
 	.oneinit = nvkm_fb_oneinit,
 	.init = nvkm_fb_init,
 	.intr = nvkm_fb_intr,
+	.stat = nvkm_fb_stat,
 };
 
 void
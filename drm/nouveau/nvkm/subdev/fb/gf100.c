@@ -26,6 +26,7 @@
 
 #include <core/memory.h>
 #include <core/option.h>
+#include <subdev/instmem.h>
 
 void
 gf100_fb_intr(struct nvkm_fb *base)
@@ -60,6 +61,12 @@ gf100_fb_oneinit(struct nvkm_fb *base)
 	if (ret)
 		return ret;
 
+	/* fault buffers, contents are never consumed */
+	nvkm_instobj_preserve(device->imem, fb->base.mmu_rd,
+			      NVKM_INSTOBJ_DISCARD);
+	nvkm_instobj_preserve(device->imem, fb->base.mmu_wr,
+			      NVKM_INSTOBJ_DISCARD);
+
 	fb->r100c10_page = alloc_page(GFP_KERNEL | __GFP_ZERO);
 	if (fb->r100c10_page) {
 		fb->r100c10 = dma_map_page(device->dev, fb->r100c10_page, 0,
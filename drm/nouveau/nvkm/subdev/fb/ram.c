@@ -25,7 +25,10 @@
 #include "ram.h"
 
 #include <core/memory.h>
+#include <subdev/bios.h>
+#include <subdev/bios/ramcfg.h>
 #include <subdev/mmu.h>
+#include <subdev/pmu.h>
 
 struct nvkm_vram {
 	struct nvkm_memory memory;
@@ -34,6 +37,245 @@ struct nvkm_vram {
 	struct nvkm_mm_node *mn;
 };
 
+/* Non-contiguous allocations from the 4KiB-granularity heaps are served
+ * by a buddy allocator, which carves naturally-aligned blocks of 4KiB to
+ * 2MiB from superblocks that are themselves allocated from nvkm_mm.
+ *
+ * Each superblock tracks its free blocks with one bitmap per order, and
+ * sits on the per-order pool for every order it has free blocks of, so
+ * that both allocation and release are O(log n) and don't depend on how
+ * fragmented the heap has become.
+ */
+#define NVKM_RAM_BUDDY_TOP  (NVKM_RAM_BUDDY_ORDERS - 1)
+#define NVKM_RAM_BUDDY_SIZE (1 << NVKM_RAM_BUDDY_TOP)
+
+struct nvkm_ram_sb {
+	struct nvkm_mm_node *mn;
+	struct rb_node tree;
+	struct list_head head[NVKM_RAM_BUDDY_ORDERS];
+	u16 free[NVKM_RAM_BUDDY_ORDERS];
+	DECLARE_BITMAP(map, NVKM_RAM_BUDDY_SIZE * 2);
+};
+
+static inline int
+nvkm_ram_sb_bit(int order, u32 index)
+{
+	return (NVKM_RAM_BUDDY_SIZE * 2) - ((NVKM_RAM_BUDDY_SIZE * 2) >> order) +
+	       (index >> order);
+}
+
+static void
+nvkm_ram_sb_set(struct nvkm_ram *ram, struct nvkm_ram_sb *sb,
+		int order, u32 index)
+{
+	__set_bit(nvkm_ram_sb_bit(order, index), sb->map);
+	if (!sb->free[order]++) {
+		list_add_tail(&sb->head[order],
+			      &ram->buddy.free[sb->mn->heap][order]);
+	}
+}
+
+static void
+nvkm_ram_sb_clr(struct nvkm_ram *ram, struct nvkm_ram_sb *sb,
+		int order, u32 index)
+{
+	__clear_bit(nvkm_ram_sb_bit(order, index), sb->map);
+	if (!--sb->free[order])
+		list_del(&sb->head[order]);
+}
+
+static struct nvkm_ram_sb *
+nvkm_ram_sb_find(struct nvkm_ram *ram, u32 offset)
+{
+	struct rb_node *node = ram->buddy.tree.rb_node;
+
+	while (node) {
+		struct nvkm_ram_sb *sb = rb_entry(node, typeof(*sb), tree);
+		if (offset < sb->mn->offset)
+			node = node->rb_left;
+		else
+		if (offset >= sb->mn->offset + NVKM_RAM_BUDDY_SIZE)
+			node = node->rb_right;
+		else
+			return sb;
+	}
+
+	return NULL;
+}
+
+static void
+nvkm_ram_sb_del(struct nvkm_ram *ram, struct nvkm_ram_sb *sb)
+{
+	rb_erase(&sb->tree, &ram->buddy.tree);
+	nvkm_mm_free(&ram->vram, &sb->mn);
+	kfree(sb);
+}
+
+static struct nvkm_ram_sb *
+nvkm_ram_sb_new(struct nvkm_ram *ram, u8 heap, u8 type)
+{
+	struct rb_node **ptr = &ram->buddy.tree.rb_node, *parent = NULL;
+	struct nvkm_ram_sb *sb;
+	int ret;
+
+	if (!(sb = kzalloc(sizeof(*sb), GFP_KERNEL)))
+		return NULL;
+
+	ret = nvkm_mm_head(&ram->vram, heap, type, NVKM_RAM_BUDDY_SIZE,
+			   NVKM_RAM_BUDDY_SIZE, NVKM_RAM_BUDDY_SIZE, &sb->mn);
+	if (ret) {
+		kfree(sb);
+		return NULL;
+	}
+
+	while (*ptr) {
+		struct nvkm_ram_sb *this = rb_entry(*ptr, typeof(*this), tree);
+		parent = *ptr;
+		if (sb->mn->offset < this->mn->offset)
+			ptr = &parent->rb_left;
+		else
+			ptr = &parent->rb_right;
+	}
+
+	rb_link_node(&sb->tree, parent, ptr);
+	rb_insert_color(&sb->tree, &ram->buddy.tree);
+	nvkm_ram_sb_set(ram, sb, NVKM_RAM_BUDDY_TOP, 0);
+	return sb;
+}
+
+static int
+nvkm_ram_buddy_get(struct nvkm_ram *ram, u8 heap, u8 type, int order,
+		   u32 *poffset)
+{
+	struct list_head *free = ram->buddy.free[heap];
+	struct nvkm_ram_sb *sb;
+	u32 index;
+	int o, bit;
+
+	/* Take the smallest free block that satisfies the request... */
+	for (o = order; o < NVKM_RAM_BUDDY_ORDERS; o++) {
+		if (!list_empty(&free[o]))
+			break;
+	}
+
+	/* ... or a new superblock if none do. */
+	if (o == NVKM_RAM_BUDDY_ORDERS) {
+		if (!(sb = nvkm_ram_sb_new(ram, heap, type)))
+			return -ENOSPC;
+		o = NVKM_RAM_BUDDY_TOP;
+	} else {
+		sb = list_first_entry(&free[o], typeof(*sb), head[o]);
+	}
+
+	bit = find_next_bit(sb->map, NVKM_RAM_BUDDY_SIZE * 2,
+			    nvkm_ram_sb_bit(o, 0));
+	index = (bit - nvkm_ram_sb_bit(o, 0)) << o;
+	nvkm_ram_sb_clr(ram, sb, o, index);
+
+	/* Split it down to the requested size, releasing the upper halves. */
+	while (o > order) {
+		o--;
+		nvkm_ram_sb_set(ram, sb, o, index + (1 << o));
+	}
+
+	*poffset = sb->mn->offset + index;
+	return 0;
+}
+
+static void
+nvkm_ram_buddy_free(struct nvkm_ram *ram, struct nvkm_ram_sb *sb,
+		    int order, u32 index)
+{
+	/* Merge with free buddies for as long as we can. */
+	while (order < NVKM_RAM_BUDDY_TOP) {
+		u32 buddy = index ^ (1 << order);
+		if (!test_bit(nvkm_ram_sb_bit(order, buddy), sb->map))
+			break;
+		nvkm_ram_sb_clr(ram, sb, order, buddy);
+		index &= ~(1 << order);
+		order++;
+	}
+
+	/* Keep a single completely free superblock per-heap around to
+	 * avoid thrashing nvkm_mm, and return any others to the heap so
+	 * that they're available to contiguous allocations again.
+	 */
+	if (order == NVKM_RAM_BUDDY_TOP &&
+	    !list_empty(&ram->buddy.free[sb->mn->heap][order])) {
+		nvkm_ram_sb_del(ram, sb);
+		return;
+	}
+
+	nvkm_ram_sb_set(ram, sb, order, index);
+}
+
+static void
+nvkm_ram_buddy_put(struct nvkm_ram *ram, u32 offset, u32 length)
+{
+	struct nvkm_ram_sb *sb = nvkm_ram_sb_find(ram, offset);
+	u32 index, end;
+
+	if (WARN_ON(!sb))
+		return;
+
+	index = offset - sb->mn->offset;
+	end = index + length;
+	while (index < end) {
+		int order = min_t(int, __ffs(index | NVKM_RAM_BUDDY_SIZE),
+				  fls(end - index) - 1);
+		nvkm_ram_buddy_free(ram, sb, order, index);
+		index += 1 << order;
+	}
+}
+
+static bool
+nvkm_ram_buddy(struct nvkm_ram *ram, u8 heap, u32 align)
+{
+	/* NV50 separates memory types by rblock, leave that to nvkm_mm. */
+	return heap != NVKM_RAM_MM_ANY && align <= NVKM_RAM_BUDDY_SIZE &&
+	       heap < ARRAY_SIZE(ram->buddy.free) &&
+	       ram->vram.block_size == 1;
+}
+
+static int
+nvkm_ram_buddy_node(struct nvkm_ram *ram, u8 heap, u8 type, int order,
+		    struct nvkm_mm_node **plast, struct nvkm_mm_node ***pnode)
+{
+	struct nvkm_mm_node *last = *plast, *node;
+	u32 offset;
+	int ret;
+
+	ret = nvkm_ram_buddy_get(ram, heap, type, order, &offset);
+	if (ret)
+		return ret;
+
+	/* Extend the previous node if the block follows on from it within
+	 * the same superblock, which keeps mapping chains short.
+	 */
+	if (last && last->offset + last->length == offset &&
+	    !((last->offset ^ offset) & ~(NVKM_RAM_BUDDY_SIZE - 1))) {
+		last->length += 1 << order;
+		return 0;
+	}
+
+	if (!(node = kzalloc(sizeof(*node), GFP_KERNEL))) {
+		nvkm_ram_buddy_put(ram, offset, 1 << order);
+		return -ENOMEM;
+	}
+
+	/* Nodes that aren't on nvkm_mm's lists belong to the buddy. */
+	INIT_LIST_HEAD(&node->nl_entry);
+	INIT_LIST_HEAD(&node->fl_entry);
+	node->heap = heap;
+	node->type = type;
+	node->offset = offset;
+	node->length = 1 << order;
+	**pnode = node;
+	*pnode = &node->next;
+	*plast = node;
+	return 0;
+}
+
 static int
 nvkm_vram_map(struct nvkm_memory *memory, u64 offset, struct nvkm_vmm *vmm,
 	      struct nvkm_vma *vma, void *argv, u32 argc)
@@ -48,6 +290,21 @@ nvkm_vram_map(struct nvkm_memory *memory, u64 offset, struct nvkm_vmm *vmm,
 	return nvkm_vmm_map(vmm, vma, argv, argc, &map);
 }
 
+static int
+nvkm_vram_map_locked(struct nvkm_memory *memory, u64 offset,
+		     struct nvkm_vmm *vmm, struct nvkm_vma *vma,
+		     void *argv, u32 argc)
+{
+	struct nvkm_vram *vram = nvkm_vram(memory);
+	struct nvkm_vmm_map map = {
+		.memory = &vram->memory,
+		.offset = offset,
+		.mem = vram->mn,
+	};
+
+	return nvkm_vmm_map_locked(vmm, vma, argv, argc, &map);
+}
+
 static u64
 nvkm_vram_size(struct nvkm_memory *memory)
 {
@@ -84,6 +341,12 @@ nvkm_vram_dtor(struct nvkm_memory *memory)
 	mutex_lock(&vram->ram->fb->subdev.mutex);
 	while ((node = next)) {
 		next = node->next;
+		if (list_empty(&node->nl_entry)) {
+			nvkm_ram_buddy_put(vram->ram, node->offset,
+					   node->length);
+			kfree(node);
+			continue;
+		}
 		nvkm_mm_free(&vram->ram->vram, &node);
 	}
 	mutex_unlock(&vram->ram->fb->subdev.mutex);
@@ -98,6 +361,7 @@ nvkm_vram = {
 	.addr = nvkm_vram_addr,
 	.size = nvkm_vram_size,
 	.map = nvkm_vram_map,
+	.map_locked = nvkm_vram_map_locked,
 };
 
 int
@@ -106,7 +370,7 @@ nvkm_ram_get(struct nvkm_device *device, u8 heap, u8 type, u8 rpage, u64 size,
 {
 	struct nvkm_ram *ram;
 	struct nvkm_mm *mm;
-	struct nvkm_mm_node **node, *r;
+	struct nvkm_mm_node **node, *r, *last = NULL;
 	struct nvkm_vram *vram;
 	u8   page = max(rpage, (u8)NVKM_RAM_MM_SHIFT);
 	u32 align = (1 << page) >> NVKM_RAM_MM_SHIFT;
@@ -128,7 +392,36 @@ nvkm_ram_get(struct nvkm_device *device, u8 heap, u8 type, u8 rpage, u64 size,
 
 	mutex_lock(&ram->fb->subdev.mutex);
 	node = &vram->mn;
-	do {
+	if (!contig && !back && nvkm_ram_buddy(ram, heap, align)) {
+		/* Take whole superblocks directly from the heap, in as few
+		 * pieces as it'll give us, and the remainder from the buddy.
+		 */
+		while (max >= NVKM_RAM_BUDDY_SIZE) {
+			ret = nvkm_mm_head(mm, heap, type,
+					   max & ~(NVKM_RAM_BUDDY_SIZE - 1),
+					   NVKM_RAM_BUDDY_SIZE,
+					   NVKM_RAM_BUDDY_SIZE, &r);
+			if (ret)
+				break;
+
+			*node = r;
+			node = &r->next;
+			max -= r->length;
+		}
+
+		while (max) {
+			int order = min_t(int, fls(max) - 1, NVKM_RAM_BUDDY_TOP);
+			u32 length = 1 << order;
+			ret = nvkm_ram_buddy_node(ram, heap, type, order,
+						  &last, &node);
+			if (ret)
+				break;
+			max -= length;
+		}
+	}
+
+	/* Anything left falls back to the first-fit allocator. */
+	while (max) {
 		if (back)
 			ret = nvkm_mm_tail(mm, heap, type, max, min, align, &r);
 		else
@@ -142,11 +435,138 @@ nvkm_ram_get(struct nvkm_device *device, u8 heap, u8 type, u8 rpage, u64 size,
 		*node = r;
 		node = &r->next;
 		max -= r->length;
-	} while (max);
+	}
 	mutex_unlock(&ram->fb->subdev.mutex);
 	return 0;
 }
 
+static const char *
+nvkm_ram_type[] = {
+	[NVKM_RAM_TYPE_UNKNOWN] = "of unknown memory type",
+	[NVKM_RAM_TYPE_STOLEN ] = "stolen system memory",
+	[NVKM_RAM_TYPE_SGRAM  ] = "SGRAM",
+	[NVKM_RAM_TYPE_SDRAM  ] = "SDRAM",
+	[NVKM_RAM_TYPE_DDR1   ] = "DDR1",
+	[NVKM_RAM_TYPE_DDR2   ] = "DDR2",
+	[NVKM_RAM_TYPE_DDR3   ] = "DDR3",
+	[NVKM_RAM_TYPE_GDDR2  ] = "GDDR2",
+	[NVKM_RAM_TYPE_GDDR3  ] = "GDDR3",
+	[NVKM_RAM_TYPE_GDDR4  ] = "GDDR4",
+	[NVKM_RAM_TYPE_GDDR5  ] = "GDDR5",
+};
+
+/******************************************************************************
+ * Reclocking script cache
+ *****************************************************************************/
+#define NVKM_RAM_SCRIPT_MAX 16
+
+struct nvkm_ram_script {
+	struct list_head head;
+	struct nvkm_ram_script_key key;
+	struct nvkm_memx_script *memx;
+};
+
+static void
+nvkm_ram_script_del(struct nvkm_ram *ram, struct nvkm_ram_script *script)
+{
+	list_del(&script->head);
+	kvfree(script->memx);
+	kfree(script);
+	ram->script.nr--;
+}
+
+static void
+nvkm_ram_script_flush_locked(struct nvkm_ram *ram)
+{
+	struct nvkm_ram_script *script, *temp;
+
+	if (!ram->script.nr)
+		return;
+
+	list_for_each_entry_safe(script, temp, &ram->script.list, head)
+		nvkm_ram_script_del(ram, script);
+	ram->script.flushes++;
+}
+
+/* Scripts depend on state that isn't part of the key (ie. the state of
+ * the hardware prior to a transition), and need to be discarded if that
+ * may have changed behind our back.
+ */
+void
+nvkm_ram_script_flush(struct nvkm_ram *ram)
+{
+	mutex_lock(&ram->script.mutex);
+	nvkm_ram_script_flush_locked(ram);
+	mutex_unlock(&ram->script.mutex);
+}
+
+/* Returns a copy of the script previously built for a transition. */
+struct nvkm_memx_script *
+nvkm_ram_script_get(struct nvkm_ram *ram, const struct nvkm_ram_script_key *key)
+{
+	struct nvkm_subdev *subdev = &ram->fb->subdev;
+	struct nvkm_memx_script *memx = NULL;
+	struct nvkm_ram_script *script;
+	u8 strap = nvbios_ramcfg_index(subdev);
+
+	mutex_lock(&ram->script.mutex);
+	if (ram->script.strap != strap) {
+		nvkm_ram_script_flush_locked(ram);
+		ram->script.strap = strap;
+	}
+
+	list_for_each_entry(script, &ram->script.list, head) {
+		if (script->key.from == key->from &&
+		    script->key.to == key->to &&
+		    script->key.step == key->step &&
+		    script->key.state == key->state) {
+			list_move(&script->head, &ram->script.list);
+			memx = kmemdup(script->memx, sizeof(*memx) +
+				       script->memx->words * 4, GFP_KERNEL);
+			break;
+		}
+	}
+
+	if (memx)
+		ram->script.hits++;
+	else
+		ram->script.misses++;
+
+	nvkm_debug(subdev, "script %d->%d/%d %s, %lld/%lld hits\n",
+		   key->from, key->to, key->step, memx ? "cached" : "built",
+		   ram->script.hits, ram->script.hits + ram->script.misses);
+	mutex_unlock(&ram->script.mutex);
+	return memx;
+}
+
+/* Takes ownership of the script, which may be NULL. */
+void
+nvkm_ram_script_put(struct nvkm_ram *ram, const struct nvkm_ram_script_key *key,
+		    struct nvkm_memx_script *memx)
+{
+	struct nvkm_ram_script *script;
+
+	if (!memx)
+		return;
+
+	if (!(script = kzalloc(sizeof(*script), GFP_KERNEL))) {
+		kvfree(memx);
+		return;
+	}
+
+	script->key = *key;
+	script->memx = memx;
+
+	mutex_lock(&ram->script.mutex);
+	list_add(&script->head, &ram->script.list);
+	if (++ram->script.nr > NVKM_RAM_SCRIPT_MAX) {
+		script = list_last_entry(&ram->script.list, typeof(*script),
+					 head);
+		nvkm_ram_script_del(ram, script);
+	}
+	mutex_unlock(&ram->script.mutex);
+}
+
 int
 nvkm_ram_init(struct nvkm_ram *ram)
 {
@@ -155,13 +575,47 @@ nvkm_ram_init(struct nvkm_ram *ram)
 	return 0;
 }
 
+void
+nvkm_ram_stat(struct nvkm_ram *ram, struct nvkm_subdev_stat *stat)
+{
+	nvkm_stat(stat, "reclock script hits", ram->script.hits);
+	nvkm_stat(stat, "reclock script misses", ram->script.misses);
+	nvkm_stat(stat, "reclock script flushes", ram->script.flushes);
+	nvkm_stat(stat, "reclock script writes", ram->script.wr32);
+	nvkm_stat(stat, "reclock script writes merged", ram->script.merged);
+}
+
 void
 nvkm_ram_del(struct nvkm_ram **pram)
 {
 	struct nvkm_ram *ram = *pram;
+	int i;
 	if (ram && !WARN_ON(!ram->func)) {
+		if (ram->script.hits || ram->script.misses) {
+			nvkm_debug(&ram->fb->subdev, "reclock scripts: %lld hits, "
+				   "%lld misses, %lld flushes\n",
+				   ram->script.hits, ram->script.misses,
+				   ram->script.flushes);
+		}
+		if (ram->script.wr32) {
+			nvkm_debug(&ram->fb->subdev, "%s reclock scripts: "
+				   "%lld writes, %lld merged\n",
+				   nvkm_ram_type[ram->type], ram->script.wr32,
+				   ram->script.merged);
+		}
+		nvkm_ram_script_flush(ram);
 		if (ram->func->dtor)
 			*pram = ram->func->dtor(ram);
+		for (i = 0; i < ARRAY_SIZE(ram->buddy.free); i++) {
+			struct list_head *free =
+				&ram->buddy.free[i][NVKM_RAM_BUDDY_TOP];
+			struct nvkm_ram_sb *sb, *temp;
+			list_for_each_entry_safe(sb, temp, free,
+						 head[NVKM_RAM_BUDDY_TOP]) {
+				nvkm_ram_sb_clr(ram, sb, NVKM_RAM_BUDDY_TOP, 0);
+				nvkm_ram_sb_del(ram, sb);
+			}
+		}
 		nvkm_mm_fini(&ram->vram);
 		kfree(*pram);
 		*pram = NULL;
@@ -172,27 +626,23 @@ int
 nvkm_ram_ctor(const struct nvkm_ram_func *func, struct nvkm_fb *fb,
 	      enum nvkm_ram_type type, u64 size, struct nvkm_ram *ram)
 {
-	static const char *name[] = {
-		[NVKM_RAM_TYPE_UNKNOWN] = "of unknown memory type",
-		[NVKM_RAM_TYPE_STOLEN ] = "stolen system memory",
-		[NVKM_RAM_TYPE_SGRAM  ] = "SGRAM",
-		[NVKM_RAM_TYPE_SDRAM  ] = "SDRAM",
-		[NVKM_RAM_TYPE_DDR1   ] = "DDR1",
-		[NVKM_RAM_TYPE_DDR2   ] = "DDR2",
-		[NVKM_RAM_TYPE_DDR3   ] = "DDR3",
-		[NVKM_RAM_TYPE_GDDR2  ] = "GDDR2",
-		[NVKM_RAM_TYPE_GDDR3  ] = "GDDR3",
-		[NVKM_RAM_TYPE_GDDR4  ] = "GDDR4",
-		[NVKM_RAM_TYPE_GDDR5  ] = "GDDR5",
-	};
 	struct nvkm_subdev *subdev = &fb->subdev;
-	int ret;
+	int ret, i, j;
 
-	nvkm_info(subdev, "%d MiB %s\n", (int)(size >> 20), name[type]);
+	nvkm_info(subdev, "%d MiB %s\n", (int)(size >> 20),
+		  nvkm_ram_type[type]);
 	ram->func = func;
 	ram->fb = fb;
 	ram->type = type;
 	ram->size = size;
+	mutex_init(&ram->script.mutex);
+	INIT_LIST_HEAD(&ram->script.list);
+
+	for (i = 0; i < ARRAY_SIZE(ram->buddy.free); i++) {
+		for (j = 0; j < NVKM_RAM_BUDDY_ORDERS; j++)
+			INIT_LIST_HEAD(&ram->buddy.free[i][j]);
+	}
+	ram->buddy.tree = RB_ROOT;
 
 	if (!nvkm_mm_initialised(&ram->vram)) {
 		ret = nvkm_mm_init(&ram->vram, NVKM_RAM_MM_NORMAL, 0,
@@ -8,6 +8,13 @@ int  nvkm_ram_new_(const struct nvkm_ram_func *, struct nvkm_fb *,
 		   enum nvkm_ram_type, u64 size, struct nvkm_ram **);
 void nvkm_ram_del(struct nvkm_ram **);
 int  nvkm_ram_init(struct nvkm_ram *);
+void nvkm_ram_stat(struct nvkm_ram *, struct nvkm_subdev_stat *);
+
+struct nvkm_memx_script;
+struct nvkm_memx_script *
+nvkm_ram_script_get(struct nvkm_ram *, const struct nvkm_ram_script_key *);
+void nvkm_ram_script_put(struct nvkm_ram *, const struct nvkm_ram_script_key *,
+			 struct nvkm_memx_script *);
 
 extern const struct nvkm_ram_func nv04_ram_func;
 
@@ -1,17 +1,23 @@
 #ifndef __NVKM_FBRAM_FUC_H__
 #define __NVKM_FBRAM_FUC_H__
-#include <subdev/fb.h>
+#include "ram.h"
 #include <subdev/pmu.h>
 
 struct ramfuc {
 	struct nvkm_memx *memx;
 	struct nvkm_fb *fb;
 	int sequence;
+
+	/* Transition being built, or a previously built script for it. */
+	struct nvkm_ram *cache;
+	struct nvkm_ram_script_key key;
+	struct nvkm_memx_script *script;
 };
 
 struct ramfuc_reg {
 	int sequence;
 	bool force;
+	bool strict; /* Writes have side-effects, never elide them. */
 	u32 addr;
 	u32 stride; /* in bytes */
 	u32 mask;
@@ -54,6 +60,16 @@ ramfuc_reg(u32 addr)
 	};
 }
 
+/* Marks a register whose writes trigger something (MRS, refresh, ...),
+ * every ram_mask() of it is then emitted even if it could be merged.
+ */
+static inline struct ramfuc_reg
+ramfuc_strict(struct ramfuc_reg reg)
+{
+	reg.strict = true;
+	return reg;
+}
+
 static inline int
 ramfuc_init(struct ramfuc *ram, struct nvkm_fb *fb)
 {
@@ -66,12 +82,56 @@ ramfuc_init(struct ramfuc *ram, struct nvkm_fb *fb)
 	return 0;
 }
 
+/* Looks for a script built previously for the same transition, which
+ * will be executed instead of building a new one if found.  Otherwise,
+ * the script built next is saved for later use.
+ */
+static inline bool
+ramfuc_cached(struct ramfuc *ram, struct nvkm_ram *base,
+	      u32 from, u32 to, u8 step, u32 state)
+{
+	ram->cache = base;
+	ram->key.from = from;
+	ram->key.to = to;
+	ram->key.step = step;
+	ram->key.state = state;
+	ram->script = nvkm_ram_script_get(base, &ram->key);
+	return ram->script != NULL;
+}
+
 static inline int
 ramfuc_exec(struct ramfuc *ram, bool exec)
 {
+	struct nvkm_ram *cache = ram->cache;
 	int ret = 0;
+
+	ram->cache = NULL;
+	if (ram->script) {
+		if (exec) {
+			ret = nvkm_memx_exec(cache->fb->subdev.device->pmu,
+					     ram->script);
+		}
+		kvfree(ram->script);
+		ram->script = NULL;
+	} else
 	if (ram->fb) {
+		struct nvkm_ram *base = ram->fb->ram;
+		struct nvkm_memx_script *script = NULL;
+		u32 wr32, merged;
+
+		/* Only keep the script if it executed successfully. */
+		if (exec && cache)
+			script = nvkm_memx_script(ram->memx);
+
+		nvkm_memx_elided(ram->memx, &wr32, &merged);
+		base->script.wr32 += wr32;
+		base->script.merged += merged;
+
 		ret = nvkm_memx_fini(&ram->memx, exec);
+		if (ret == 0)
+			nvkm_ram_script_put(cache, &ram->key, script);
+		else
+			kvfree(script);
 		ram->fb = NULL;
 	}
 	return ret;
@@ -86,8 +146,11 @@ ramfuc_rd32(struct ramfuc *ram, struct ramfuc_reg *reg)
 	return reg->data;
 }
 
+/* Only writes from ramfuc_mask() may be elided by memx, explicit writes
+ * are always emitted as-is.
+ */
 static inline void
-ramfuc_wr32(struct ramfuc *ram, struct ramfuc_reg *reg, u32 data)
+ramfuc_emit(struct ramfuc *ram, struct ramfuc_reg *reg, u32 data, bool elide)
 {
 	unsigned int mask, off = 0;
 
@@ -95,12 +158,24 @@ ramfuc_wr32(struct ramfuc *ram, struct ramfuc_reg *reg, u32 data)
 	reg->data = data;
 
 	for (mask = reg->mask; mask > 0; mask = (mask & ~1) >> 1) {
-		if (mask & 1)
-			nvkm_memx_wr32(ram->memx, reg->addr+off, reg->data);
+		if (mask & 1) {
+			if (elide)
+				nvkm_memx_wr32_elide(ram->memx, reg->addr + off,
+						     reg->data);
+			else
+				nvkm_memx_wr32(ram->memx, reg->addr + off,
+					       reg->data);
+		}
 		off += reg->stride;
 	}
 }
 
+static inline void
+ramfuc_wr32(struct ramfuc *ram, struct ramfuc_reg *reg, u32 data)
+{
+	ramfuc_emit(ram, reg, data, false);
+}
+
 static inline void
 ramfuc_nuke(struct ramfuc *ram, struct ramfuc_reg *reg)
 {
@@ -112,7 +187,8 @@ ramfuc_mask(struct ramfuc *ram, struct ramfuc_reg *reg, u32 mask, u32 data)
 {
 	u32 temp = ramfuc_rd32(ram, reg);
 	if (temp != ((temp & ~mask) | data) || reg->force) {
-		ramfuc_wr32(ram, reg, (temp & ~mask) | data);
+		ramfuc_emit(ram, reg, (temp & ~mask) | data,
+			    !reg->force && !reg->strict);
 		reg->force = false;
 	}
 	return temp;
@@ -162,6 +238,8 @@ ramfuc_unblock(struct ramfuc *ram)
 
 #define ram_init(s,p)        ramfuc_init(&(s)->base, (p))
 #define ram_exec(s,e)        ramfuc_exec(&(s)->base, (e))
+#define ram_cached(s,r,f,t,n,x)                                                \
+	ramfuc_cached(&(s)->base, (r), (f), (t), (n), (x))
 #define ram_have(s,r)        ((s)->r_##r.addr != 0x000000)
 #define ram_rd32(s,r)        ramfuc_rd32(&(s)->base, &(s)->r_##r)
 #define ram_wr32(s,r,d)      ramfuc_wr32(&(s)->base, &(s)->r_##r, (d))
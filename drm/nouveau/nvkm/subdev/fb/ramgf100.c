@@ -609,22 +609,22 @@ gf100_ram_new_(const struct nvkm_ram_func *func,
 	ram->fuc.r_0x10f29c = ramfuc_reg(0x10f29c);
 	ram->fuc.r_0x10f2a0 = ramfuc_reg(0x10f2a0);
 
-	ram->fuc.r_0x10f300 = ramfuc_reg(0x10f300);
-	ram->fuc.r_0x10f338 = ramfuc_reg(0x10f338);
-	ram->fuc.r_0x10f340 = ramfuc_reg(0x10f340);
-	ram->fuc.r_0x10f344 = ramfuc_reg(0x10f344);
-	ram->fuc.r_0x10f348 = ramfuc_reg(0x10f348);
+	ram->fuc.r_0x10f300 = ramfuc_strict(ramfuc_reg(0x10f300));
+	ram->fuc.r_0x10f338 = ramfuc_strict(ramfuc_reg(0x10f338));
+	ram->fuc.r_0x10f340 = ramfuc_strict(ramfuc_reg(0x10f340));
+	ram->fuc.r_0x10f344 = ramfuc_strict(ramfuc_reg(0x10f344));
+	ram->fuc.r_0x10f348 = ramfuc_strict(ramfuc_reg(0x10f348));
 
 	ram->fuc.r_0x10f910 = ramfuc_reg(0x10f910);
 	ram->fuc.r_0x10f914 = ramfuc_reg(0x10f914);
 
 	ram->fuc.r_0x100b0c = ramfuc_reg(0x100b0c);
 	ram->fuc.r_0x10f050 = ramfuc_reg(0x10f050);
-	ram->fuc.r_0x10f090 = ramfuc_reg(0x10f090);
+	ram->fuc.r_0x10f090 = ramfuc_strict(ramfuc_reg(0x10f090));
 	ram->fuc.r_0x10f200 = ramfuc_reg(0x10f200);
 	ram->fuc.r_0x10f210 = ramfuc_reg(0x10f210);
-	ram->fuc.r_0x10f310 = ramfuc_reg(0x10f310);
-	ram->fuc.r_0x10f314 = ramfuc_reg(0x10f314);
+	ram->fuc.r_0x10f310 = ramfuc_strict(ramfuc_reg(0x10f310));
+	ram->fuc.r_0x10f314 = ramfuc_strict(ramfuc_reg(0x10f314));
 	ram->fuc.r_0x10f610 = ramfuc_reg(0x10f610);
 	ram->fuc.r_0x10f614 = ramfuc_reg(0x10f614);
 	ram->fuc.r_0x10f800 = ramfuc_reg(0x10f800);
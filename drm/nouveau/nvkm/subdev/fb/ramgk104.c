@@ -137,6 +137,10 @@ struct gk104_ram {
 /*******************************************************************************
  * GDDR5
  ******************************************************************************/
+/* Training is kicked off on all partitions at once via the broadcast
+ * registers, and only then do we wait on each partition's status, so the
+ * partitions train in parallel and the waits overlap.  Keep it that way.
+ */
 static void
 gk104_ram_train(struct gk104_ramfuc *fuc, u32 mask, u32 data)
 {
@@ -1045,13 +1049,22 @@ gk104_ram_calc_xits(struct gk104_ram *ram, struct nvkm_ram_data *next)
 	int refclk, i;
 	int ret;
 
+	/* The script depends on which PLL is currently in use, as well as
+	 * the clocks, so that's part of the key.
+	 */
+	ram->mode = (next->freq > fuc->refpll.vco1.max_freq) ? 2 : 1;
+	ram->from = nvkm_rd32(subdev->device, 0x1373f4) & 0x0000000f;
+	ram->base.freq = next->freq;
+
+	if (ram_cached(fuc, &ram->base, ram->base.former.freq,
+		       ram->base.target.freq, next == &ram->base.target,
+		       ram->from))
+		return 0;
+
 	ret = ram_init(fuc, ram->base.fb);
 	if (ret)
 		return ret;
 
-	ram->mode = (next->freq > fuc->refpll.vco1.max_freq) ? 2 : 1;
-	ram->from = ram_rd32(fuc, 0x1373f4) & 0x0000000f;
-
 	/* XXX: this is *not* what nvidia do.  on fermi nvidia generally
 	 * select, based on some unknown condition, one of the two possible
 	 * reference frequencies listed in the vbios table for mempll and
@@ -1087,7 +1100,6 @@ gk104_ram_calc_xits(struct gk104_ram *ram, struct nvkm_ram_data *next)
 		if (ram_have(fuc, mr[i]))
 			ram->base.mr[i] = ram_rd32(fuc, mr[i]);
 	}
-	ram->base.freq = next->freq;
 
 	switch (ram->base.type) {
 	case NVKM_RAM_TYPE_DDR3:
@@ -1657,21 +1669,21 @@ gk104_ram_new_(const struct nvkm_ram_func *func, struct nvkm_fb *fb,
 
 	switch (ram->base.type) {
 	case NVKM_RAM_TYPE_GDDR5:
-		ram->fuc.r_mr[0] = ramfuc_reg(0x10f300);
-		ram->fuc.r_mr[1] = ramfuc_reg(0x10f330);
-		ram->fuc.r_mr[2] = ramfuc_reg(0x10f334);
-		ram->fuc.r_mr[3] = ramfuc_reg(0x10f338);
-		ram->fuc.r_mr[4] = ramfuc_reg(0x10f33c);
-		ram->fuc.r_mr[5] = ramfuc_reg(0x10f340);
-		ram->fuc.r_mr[6] = ramfuc_reg(0x10f344);
-		ram->fuc.r_mr[7] = ramfuc_reg(0x10f348);
-		ram->fuc.r_mr[8] = ramfuc_reg(0x10f354);
-		ram->fuc.r_mr[15] = ramfuc_reg(0x10f34c);
+		ram->fuc.r_mr[0] = ramfuc_strict(ramfuc_reg(0x10f300));
+		ram->fuc.r_mr[1] = ramfuc_strict(ramfuc_reg(0x10f330));
+		ram->fuc.r_mr[2] = ramfuc_strict(ramfuc_reg(0x10f334));
+		ram->fuc.r_mr[3] = ramfuc_strict(ramfuc_reg(0x10f338));
+		ram->fuc.r_mr[4] = ramfuc_strict(ramfuc_reg(0x10f33c));
+		ram->fuc.r_mr[5] = ramfuc_strict(ramfuc_reg(0x10f340));
+		ram->fuc.r_mr[6] = ramfuc_strict(ramfuc_reg(0x10f344));
+		ram->fuc.r_mr[7] = ramfuc_strict(ramfuc_reg(0x10f348));
+		ram->fuc.r_mr[8] = ramfuc_strict(ramfuc_reg(0x10f354));
+		ram->fuc.r_mr[15] = ramfuc_strict(ramfuc_reg(0x10f34c));
 		break;
 	case NVKM_RAM_TYPE_DDR3:
-		ram->fuc.r_mr[0] = ramfuc_reg(0x10f300);
-		ram->fuc.r_mr[1] = ramfuc_reg(0x10f304);
-		ram->fuc.r_mr[2] = ramfuc_reg(0x10f320);
+		ram->fuc.r_mr[0] = ramfuc_strict(ramfuc_reg(0x10f300));
+		ram->fuc.r_mr[1] = ramfuc_strict(ramfuc_reg(0x10f304));
+		ram->fuc.r_mr[2] = ramfuc_strict(ramfuc_reg(0x10f320));
 		break;
 	default:
 		break;
@@ -1680,10 +1692,10 @@ gk104_ram_new_(const struct nvkm_ram_func *func, struct nvkm_fb *fb,
 	ram->fuc.r_0x62c000 = ramfuc_reg(0x62c000);
 	ram->fuc.r_0x10f200 = ramfuc_reg(0x10f200);
 	ram->fuc.r_0x10f210 = ramfuc_reg(0x10f210);
-	ram->fuc.r_0x10f310 = ramfuc_reg(0x10f310);
-	ram->fuc.r_0x10f314 = ramfuc_reg(0x10f314);
+	ram->fuc.r_0x10f310 = ramfuc_strict(ramfuc_reg(0x10f310));
+	ram->fuc.r_0x10f314 = ramfuc_strict(ramfuc_reg(0x10f314));
 	ram->fuc.r_0x10f318 = ramfuc_reg(0x10f318);
-	ram->fuc.r_0x10f090 = ramfuc_reg(0x10f090);
+	ram->fuc.r_0x10f090 = ramfuc_strict(ramfuc_reg(0x10f090));
 	ram->fuc.r_0x10f69c = ramfuc_reg(0x10f69c);
 	ram->fuc.r_0x10f824 = ramfuc_reg(0x10f824);
 	ram->fuc.r_0x1373f0 = ramfuc_reg(0x1373f0);
@@ -556,6 +556,11 @@ gt215_ram_calc(struct nvkm_ram *base, u32 freq)
 
 	gt215_ram_timing_calc(ram, timing);
 
+	if (ram_cached(fuc, &ram->base, nvkm_clk_read(device->clk,
+						      nv_clk_src_mem),
+		       freq, 0, 0))
+		return 0;
+
 	ret = ram_init(fuc, ram->base.fb);
 	if (ret)
 		return ret;
@@ -988,15 +993,19 @@ gt215_ram_new(struct nvkm_fb *fb, struct nvkm_ram **pram)
 	ram->fuc.r_0x611200 = ramfuc_reg(0x611200);
 
 	if (ram->base.ranks > 1) {
-		ram->fuc.r_mr[0] = ramfuc_reg2(0x1002c0, 0x1002c8);
-		ram->fuc.r_mr[1] = ramfuc_reg2(0x1002c4, 0x1002cc);
-		ram->fuc.r_mr[2] = ramfuc_reg2(0x1002e0, 0x1002e8);
-		ram->fuc.r_mr[3] = ramfuc_reg2(0x1002e4, 0x1002ec);
+		ram->fuc.r_mr[0] = ramfuc_strict(
+			ramfuc_reg2(0x1002c0, 0x1002c8));
+		ram->fuc.r_mr[1] = ramfuc_strict(
+			ramfuc_reg2(0x1002c4, 0x1002cc));
+		ram->fuc.r_mr[2] = ramfuc_strict(
+			ramfuc_reg2(0x1002e0, 0x1002e8));
+		ram->fuc.r_mr[3] = ramfuc_strict(
+			ramfuc_reg2(0x1002e4, 0x1002ec));
 	} else {
-		ram->fuc.r_mr[0] = ramfuc_reg(0x1002c0);
-		ram->fuc.r_mr[1] = ramfuc_reg(0x1002c4);
-		ram->fuc.r_mr[2] = ramfuc_reg(0x1002e0);
-		ram->fuc.r_mr[3] = ramfuc_reg(0x1002e4);
+		ram->fuc.r_mr[0] = ramfuc_strict(ramfuc_reg(0x1002c0));
+		ram->fuc.r_mr[1] = ramfuc_strict(ramfuc_reg(0x1002c4));
+		ram->fuc.r_mr[2] = ramfuc_strict(ramfuc_reg(0x1002e0));
+		ram->fuc.r_mr[3] = ramfuc_strict(ramfuc_reg(0x1002e4));
 	}
 	ram->fuc.r_gpio[0] = ramfuc_reg(0x00e104);
 	ram->fuc.r_gpio[1] = ramfuc_reg(0x00e108);
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2017 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "priv.h"
+
+/* Comptags are tracked with a bitmap of allocated tags, and a second level
+ * bitmap marking the words of the first that are completely allocated, so
+ * that searches can skip over densely-used regions a word at a time.
+ */
+static void
+nvkm_fb_tags_update(struct nvkm_fb *fb, u32 offset, u32 nr)
+{
+	u32 word = offset / BITS_PER_LONG;
+	u32 last = (offset + nr - 1) / BITS_PER_LONG;
+
+	for (; word <= last; word++) {
+		if (fb->comptags.used[word] == ~0UL)
+			__set_bit(word, fb->comptags.full);
+		else
+			__clear_bit(word, fb->comptags.full);
+	}
+}
+
+static int
+nvkm_fb_tags_find(struct nvkm_fb *fb, u32 nr)
+{
+	const u32 words = BITS_TO_LONGS(fb->comptags.nr);
+	const u32 tags = fb->comptags.nr;
+	u32 pos = 0, next, word;
+
+	while (pos < tags) {
+		word = pos / BITS_PER_LONG;
+		if (test_bit(word, fb->comptags.full)) {
+			word = find_next_zero_bit(fb->comptags.full, words, word);
+			pos = word * BITS_PER_LONG;
+			continue;
+		}
+
+		pos = find_next_zero_bit(fb->comptags.used, tags, pos);
+		if (pos + nr > tags)
+			break;
+
+		next = find_next_bit(fb->comptags.used, pos + nr, pos);
+		if (next == pos + nr)
+			return pos;
+		pos = next;
+	}
+
+	return -ENOSPC;
+}
+
+int
+nvkm_fb_tags_get(struct nvkm_fb *fb, u32 nr, u32 *offset)
+{
+	int ret;
+
+	if (!nr)
+		return -EINVAL;
+
+	spin_lock(&fb->comptags.lock);
+	ret = nvkm_fb_tags_find(fb, nr);
+	if (ret >= 0) {
+		bitmap_set(fb->comptags.used, ret, nr);
+		nvkm_fb_tags_update(fb, ret, nr);
+		fb->comptags.busy += nr;
+		*offset = ret;
+		ret = 0;
+	}
+	spin_unlock(&fb->comptags.lock);
+	return ret;
+}
+
+void
+nvkm_fb_tags_put(struct nvkm_fb *fb, u32 offset, u32 nr)
+{
+	spin_lock(&fb->comptags.lock);
+	bitmap_clear(fb->comptags.used, offset, nr);
+	nvkm_fb_tags_update(fb, offset, nr);
+	fb->comptags.busy -= nr;
+	spin_unlock(&fb->comptags.lock);
+}
+
+void
+nvkm_fb_tags_fini(struct nvkm_fb *fb)
+{
+	kfree(fb->comptags.used);
+	fb->comptags.used = NULL;
+	kfree(fb->comptags.full);
+	fb->comptags.full = NULL;
+	fb->comptags.nr = 0;
+	fb->comptags.busy = 0;
+}
+
+int
+nvkm_fb_tags_init(struct nvkm_fb *fb, u32 nr)
+{
+	const u32 words = BITS_TO_LONGS(nr);
+
+	nvkm_fb_tags_fini(fb);
+	spin_lock_init(&fb->comptags.lock);
+	if (!nr)
+		return 0;
+
+	fb->comptags.used = kcalloc(words, sizeof(long), GFP_KERNEL);
+	fb->comptags.full = kcalloc(BITS_TO_LONGS(words), sizeof(long),
+				    GFP_KERNEL);
+	if (!fb->comptags.used || !fb->comptags.full) {
+		nvkm_fb_tags_fini(fb);
+		return -ENOMEM;
+	}
+
+	/* Mark the tail of the last word as allocated, so it's never used. */
+	bitmap_set(fb->comptags.used, nr, words * BITS_PER_LONG - nr);
+	nvkm_fb_tags_update(fb, nr - 1, 1);
+	fb->comptags.nr = nr;
+	return 0;
+}
@@ -29,53 +29,71 @@
  * instmem object base implementation
  *****************************************************************************/
 static void
-nvkm_instobj_load(struct nvkm_instobj *iobj)
+nvkm_instobj_load(struct nvkm_instmem *imem, struct nvkm_instobj *iobj,
+		  struct nvkm_instmem_xfer *xfer)
 {
 	struct nvkm_memory *memory = &iobj->memory;
 	const u64 size = nvkm_memory_size(memory);
-	void __iomem *map;
-	int i;
-
-	if (!(map = nvkm_kmap(memory))) {
-		for (i = 0; i < size; i += 4)
-			nvkm_wo32(memory, i, iobj->suspend[i / 4]);
-	} else {
-		memcpy_toio(map, iobj->suspend, size);
-	}
-	nvkm_done(memory);
 
-	kvfree(iobj->suspend);
-	iobj->suspend = NULL;
+	xfer->memory = memory;
+	xfer->offset = 0;
+	xfer->size = size;
+	xfer->data = iobj->suspend;
+	xfer->write = true;
+	imem->suspend.restored += size;
 }
 
 static int
-nvkm_instobj_save(struct nvkm_instobj *iobj)
+nvkm_instobj_save(struct nvkm_instmem *imem, struct nvkm_instobj *iobj,
+		  struct nvkm_instmem_xfer *xfer)
 {
 	struct nvkm_memory *memory = &iobj->memory;
 	const u64 size = nvkm_memory_size(memory);
-	void __iomem *map;
-	int i;
+
+	xfer->memory = NULL;
+
+	switch (iobj->preserve) {
+	case NVKM_INSTOBJ_DISCARD:
+		imem->suspend.discarded += size;
+		return 0;
+	case NVKM_INSTOBJ_CONST:
+		if (iobj->suspend) {
+			imem->suspend.kept += size;
+			return 0;
+		}
+		break;
+	default:
+		break;
+	}
 
 	iobj->suspend = kvmalloc(size, GFP_KERNEL);
 	if (!iobj->suspend)
 		return -ENOMEM;
 
-	if (!(map = nvkm_kmap(memory))) {
-		for (i = 0; i < size; i += 4)
-			iobj->suspend[i / 4] = nvkm_ro32(memory, i);
-	} else {
-		memcpy_fromio(iobj->suspend, map, size);
-	}
-	nvkm_done(memory);
+	xfer->memory = memory;
+	xfer->offset = 0;
+	xfer->size = size;
+	xfer->data = iobj->suspend;
+	xfer->write = false;
+	imem->suspend.saved += size;
 	return 0;
 }
 
+void
+nvkm_instobj_preserve(struct nvkm_instmem *imem, struct nvkm_memory *memory,
+		      enum nvkm_instobj_preserve preserve)
+{
+	if (!imem->func->persistent)
+		nvkm_instobj(memory)->preserve = preserve;
+}
+
 void
 nvkm_instobj_dtor(struct nvkm_instmem *imem, struct nvkm_instobj *iobj)
 {
 	spin_lock(&imem->lock);
 	list_del(&iobj->head);
 	spin_unlock(&imem->lock);
+	kvfree(iobj->suspend);
 }
 
 void
@@ -83,6 +101,7 @@ nvkm_instobj_ctor(const struct nvkm_memory_func *func,
 		  struct nvkm_instmem *imem, struct nvkm_instobj *iobj)
 {
 	nvkm_memory_ctor(func, &iobj->memory);
+	iobj->preserve = NVKM_INSTOBJ_PRESERVE;
 	iobj->suspend = NULL;
 	spin_lock(&imem->lock);
 	list_add_tail(&iobj->head, &imem->list);
@@ -95,7 +114,6 @@ nvkm_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
 {
 	struct nvkm_subdev *subdev = &imem->subdev;
 	struct nvkm_memory *memory = NULL;
-	u32 offset;
 	int ret;
 
 	ret = imem->func->memory_new(imem, size, align, zero, &memory);
@@ -108,13 +126,8 @@ nvkm_instobj_new(struct nvkm_instmem *imem, u32 size, u32 align, bool zero,
 		   zero, nvkm_memory_addr(memory), nvkm_memory_size(memory));
 
 	if (!imem->func->zero && zero) {
-		void __iomem *map = nvkm_kmap(memory);
-		if (unlikely(!map)) {
-			for (offset = 0; offset < size; offset += 4)
-				nvkm_wo32(memory, offset, 0x00000000);
-		} else {
-			memset_io(map, 0x00, size);
-		}
+		nvkm_kmap(memory);
+		nvkm_memory_fill(memory, 0, 0x00000000, size);
 		nvkm_done(memory);
 	}
 
@@ -141,6 +154,13 @@ nvkm_instmem_wr32(struct nvkm_instmem *imem, u32 addr, u32 data)
 	return imem->func->wr32(imem, addr, data);
 }
 
+void
+nvkm_instmem_bar2_fini(struct nvkm_instmem *imem)
+{
+	if (imem && imem->func->bar2_fini)
+		imem->func->bar2_fini(imem);
+}
+
 void
 nvkm_instmem_boot(struct nvkm_instmem *imem)
 {
@@ -156,26 +176,144 @@ nvkm_instmem_boot(struct nvkm_instmem *imem)
 	spin_unlock(&imem->lock);
 }
 
+static void
+nvkm_instmem_xfer(struct nvkm_instmem *imem, struct nvkm_instmem_xfer *xfer,
+		  int nr, bool slow)
+{
+	struct nvkm_memory *memory;
+	int i;
+
+	if (slow && imem->func->xfer) {
+		imem->func->xfer(imem, xfer, nr);
+		return;
+	}
+
+	for (i = 0; i < nr; i++) {
+		memory = xfer[i].memory;
+		nvkm_kmap(memory);
+		if (xfer[i].write) {
+			nvkm_memory_copy_to(memory, xfer[i].offset,
+					    xfer[i].data, xfer[i].size);
+		} else {
+			nvkm_memory_copy_from(memory, xfer[i].offset,
+					      xfer[i].data, xfer[i].size);
+		}
+		nvkm_done(memory);
+	}
+}
+
+/* Objects that have to be accessed via the slow path are handed to the
+ * backend as a single batch, so it can order the accesses to suit the
+ * hardware.  Everything else is copied an object at a time.
+ */
+static struct nvkm_instmem_xfer *
+nvkm_instmem_xfer_new(struct list_head *list, bool slow,
+		      struct nvkm_instmem_xfer *one, int *max)
+{
+	struct nvkm_instmem_xfer *xfer = NULL;
+	struct nvkm_instobj *iobj;
+	int nr = 0;
+
+	if (slow) {
+		list_for_each_entry(iobj, list, head)
+			nr++;
+		if (nr > 1)
+			xfer = kvmalloc_array(nr, sizeof(*xfer), GFP_KERNEL);
+	}
+
+	if (!xfer) {
+		*max = 1;
+		return one;
+	}
+
+	*max = nr;
+	return xfer;
+}
+
+static int
+nvkm_instmem_save(struct nvkm_instmem *imem, struct list_head *list, bool slow)
+{
+	struct nvkm_instmem_xfer *xfer, one;
+	struct nvkm_instobj *iobj;
+	int nr = 0, max, ret = 0;
+
+	xfer = nvkm_instmem_xfer_new(list, slow, &one, &max);
+
+	list_for_each_entry(iobj, list, head) {
+		ret = nvkm_instobj_save(imem, iobj, &xfer[nr]);
+		if (ret)
+			break;
+
+		if (xfer[nr].memory && ++nr == max) {
+			nvkm_instmem_xfer(imem, xfer, nr, slow);
+			nr = 0;
+		}
+	}
+
+	if (nr)
+		nvkm_instmem_xfer(imem, xfer, nr, slow);
+	if (xfer != &one)
+		kvfree(xfer);
+	return ret;
+}
+
+static void
+nvkm_instmem_load(struct nvkm_instmem *imem, struct list_head *list, bool slow)
+{
+	struct nvkm_instmem_xfer *xfer, one;
+	struct nvkm_instobj *iobj;
+	int nr = 0, max;
+
+	xfer = nvkm_instmem_xfer_new(list, slow, &one, &max);
+
+	list_for_each_entry(iobj, list, head) {
+		if (!iobj->suspend)
+			continue;
+
+		nvkm_instobj_load(imem, iobj, &xfer[nr]);
+		if (++nr == max) {
+			nvkm_instmem_xfer(imem, xfer, nr, slow);
+			nr = 0;
+		}
+	}
+
+	if (nr)
+		nvkm_instmem_xfer(imem, xfer, nr, slow);
+	if (xfer != &one)
+		kvfree(xfer);
+
+	list_for_each_entry(iobj, list, head) {
+		if (iobj->preserve != NVKM_INSTOBJ_CONST) {
+			kvfree(iobj->suspend);
+			iobj->suspend = NULL;
+		}
+	}
+}
+
 static int
 nvkm_instmem_fini(struct nvkm_subdev *subdev, bool suspend)
 {
 	struct nvkm_instmem *imem = nvkm_instmem(subdev);
-	struct nvkm_instobj *iobj;
+	int ret;
 
 	if (suspend) {
-		list_for_each_entry(iobj, &imem->list, head) {
-			int ret = nvkm_instobj_save(iobj);
-			if (ret)
-				return ret;
-		}
+		memset(&imem->suspend, 0x00, sizeof(imem->suspend));
+
+		ret = nvkm_instmem_save(imem, &imem->list, false);
+		if (ret)
+			return ret;
 
 		nvkm_bar_bar2_fini(subdev->device);
 
-		list_for_each_entry(iobj, &imem->boot, head) {
-			int ret = nvkm_instobj_save(iobj);
-			if (ret)
-				return ret;
-		}
+		/* BAR2 is gone, bootstrapped objects need the slow path. */
+		ret = nvkm_instmem_save(imem, &imem->boot, true);
+		if (ret)
+			return ret;
+
+		nvkm_debug(subdev, "suspend: saved %lld, kept %lld, "
+				   "discarded %lld bytes\n",
+			   imem->suspend.saved, imem->suspend.kept,
+			   imem->suspend.discarded);
 	}
 
 	if (imem->func->fini)
@@ -188,20 +326,16 @@ static int
 nvkm_instmem_init(struct nvkm_subdev *subdev)
 {
 	struct nvkm_instmem *imem = nvkm_instmem(subdev);
-	struct nvkm_instobj *iobj;
 
-	list_for_each_entry(iobj, &imem->boot, head) {
-		if (iobj->suspend)
-			nvkm_instobj_load(iobj);
-	}
+	imem->suspend.restored = 0;
 
+	nvkm_instmem_load(imem, &imem->boot, true);
 	nvkm_bar_bar2_init(subdev->device);
+	nvkm_instmem_load(imem, &imem->list, false);
 
-	list_for_each_entry(iobj, &imem->list, head) {
-		if (iobj->suspend)
-			nvkm_instobj_load(iobj);
-	}
-
+	if (imem->suspend.restored)
+		nvkm_debug(subdev, "resume: restored %lld bytes\n",
+			   imem->suspend.restored);
 	return 0;
 }
 
@@ -214,6 +348,14 @@ nvkm_instmem_oneinit(struct nvkm_subdev *subdev)
 	return 0;
 }
 
+static void
+nvkm_instmem_stat(struct nvkm_subdev *subdev, struct nvkm_subdev_stat *stat)
+{
+	struct nvkm_instmem *imem = nvkm_instmem(subdev);
+	if (imem->func->stat)
+		imem->func->stat(imem, stat);
+}
+
 static void *
 nvkm_instmem_dtor(struct nvkm_subdev *subdev)
 {
@@ -229,6 +371,7 @@ nvkm_instmem = {
 	.oneinit = nvkm_instmem_oneinit,
 	.init = nvkm_instmem_init,
 	.fini = nvkm_instmem_fini,
+	.stat = nvkm_instmem_stat,
 };
 
 void
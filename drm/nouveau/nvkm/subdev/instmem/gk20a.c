@@ -39,7 +39,13 @@
  *
  * To improve performance, CPU mappings are not removed upon instobj release.
  * Instead they are placed into a LRU list to be recycled when the mapped space
- * goes beyond a certain threshold. At the moment this limit is 1MB.
+ * goes beyond a certain threshold.  The threshold follows the amount of
+ * instmem that is mapped and in use at once, between 1MB and 16MB.
+ *
+ * Small IOMMU-backed objects are given GPU addresses from a range of IOMMU
+ * address-space reserved up-front, which is managed with a bitmap rather
+ * than the nvkm_mm allocator, and their pages are mapped into the IOMMU a
+ * physically-contiguous run at a time.
  */
 #include "priv.h"
 
@@ -81,6 +87,9 @@ struct gk20a_instobj_iommu {
 	/* how many clients are using vaddr? */
 	u32 use_cpt;
 
+	/* GPU address range, if allocated from gk20a_instmem::pool */
+	struct nvkm_mm_node r;
+
 	/* will point to the higher half of pages */
 	dma_addr_t *dma_addrs;
 	/* array of base.mem->size pages (+ dma_addr_ts) */
@@ -92,12 +101,14 @@ struct gk20a_instobj_iommu {
 struct gk20a_instmem {
 	struct nvkm_instmem base;
 
-	/* protects vaddr_* and gk20a_instobj::vaddr* */
+	/* protects vaddr_*, pool and gk20a_instobj::vaddr* */
 	struct mutex lock;
 
 	/* CPU mappings LRU */
 	unsigned int vaddr_use;
 	unsigned int vaddr_max;
+	unsigned int vaddr_busy; /* mappings with users */
+	unsigned int vaddr_peak;
 	struct list_head vaddr_lru;
 
 	/* Only used if IOMMU if present */
@@ -107,11 +118,37 @@ struct gk20a_instmem {
 	unsigned long iommu_pgshift;
 	u16 iommu_bit;
 
+	/* IOMMU address-space reserved for small objects */
+	struct {
+		struct nvkm_mm_node *mn;
+		unsigned long *used;
+		u32 pages;
+	} pool;
+
+	struct {
+		u64 vaddr_hit;
+		u64 vaddr_map;
+		u64 vaddr_evict;
+		u64 pool;
+		u64 mm;
+		u64 iommu_map;
+	} stats;
+
 	/* Only used by DMA API */
 	unsigned long attrs;
 };
 #define gk20a_instmem(p) container_of((p), struct gk20a_instmem, base)
 
+#define GK20A_INSTMEM_VADDR_MIN  0x00100000
+#define GK20A_INSTMEM_VADDR_MAX  0x01000000
+
+#define GK20A_INSTMEM_POOL_SIZE  0x00400000
+#define GK20A_INSTMEM_POOL_ALIGN 0x00010000
+#define GK20A_INSTMEM_POOL_MAX   0x00010000
+
+/* Largest chunk of backing pages to attempt to allocate at once. */
+#define GK20A_INSTOBJ_MAX_ORDER 4
+
 static enum nvkm_memory_target
 gk20a_instobj_target(struct nvkm_memory *memory)
 {
@@ -159,6 +196,11 @@ gk20a_instobj_iommu_recycle_vaddr(struct gk20a_instobj_iommu *obj)
 static void
 gk20a_instmem_vaddr_gc(struct gk20a_instmem *imem, const u64 size)
 {
+	/* keep unused mappings around in proportion to the working set */
+	imem->vaddr_max = clamp_t(u32, imem->vaddr_peak * 2,
+				  GK20A_INSTMEM_VADDR_MIN,
+				  GK20A_INSTMEM_VADDR_MAX);
+
 	while (imem->vaddr_use + size > imem->vaddr_max) {
 		/* no candidate that can be unmapped, abort... */
 		if (list_empty(&imem->vaddr_lru))
@@ -167,6 +209,7 @@ gk20a_instmem_vaddr_gc(struct gk20a_instmem *imem, const u64 size)
 		gk20a_instobj_iommu_recycle_vaddr(
 				list_first_entry(&imem->vaddr_lru,
 				struct gk20a_instobj_iommu, vaddr_node));
+		imem->stats.vaddr_evict++;
 	}
 }
 
@@ -199,6 +242,7 @@ gk20a_instobj_acquire_iommu(struct nvkm_memory *memory)
 			/* remove from LRU list since mapping in use again */
 			list_del(&node->vaddr_node);
 		}
+		imem->stats.vaddr_hit++;
 		goto out;
 	}
 
@@ -215,11 +259,15 @@ gk20a_instobj_acquire_iommu(struct nvkm_memory *memory)
 	}
 
 	imem->vaddr_use += size;
+	imem->stats.vaddr_map++;
 	nvkm_debug(&imem->base.subdev, "vaddr used: %x/%x\n",
 		   imem->vaddr_use, imem->vaddr_max);
 
 out:
-	node->use_cpt++;
+	if (!node->use_cpt++) {
+		imem->vaddr_busy += size;
+		imem->vaddr_peak = max(imem->vaddr_peak, imem->vaddr_busy);
+	}
 	mutex_unlock(&imem->lock);
 
 	return node->base.vaddr;
@@ -251,8 +299,10 @@ gk20a_instobj_release_iommu(struct nvkm_memory *memory)
 		goto out;
 
 	/* add unused objs to the LRU list to recycle their mapping */
-	if (--node->use_cpt == 0)
+	if (--node->use_cpt == 0) {
+		imem->vaddr_busy -= nvkm_memory_size(memory);
 		list_add_tail(&node->vaddr_node, &imem->vaddr_lru);
+	}
 
 out:
 	mutex_unlock(&imem->lock);
@@ -308,6 +358,47 @@ out:
 	return node;
 }
 
+static struct nvkm_mm_node *
+gk20a_instmem_pool_get(struct gk20a_instmem *imem,
+		       struct gk20a_instobj_iommu *node, u32 npages, u32 align)
+{
+	unsigned long pos = ~0UL;
+
+	if (!imem->pool.pages ||
+	    (npages << imem->iommu_pgshift) > GK20A_INSTMEM_POOL_MAX ||
+	    align > GK20A_INSTMEM_POOL_ALIGN)
+		return NULL;
+
+	mutex_lock(&imem->lock);
+	pos = bitmap_find_next_zero_area(imem->pool.used, imem->pool.pages, 0,
+					 npages,
+					 (align >> imem->iommu_pgshift) - 1);
+	if (pos + npages <= imem->pool.pages) {
+		bitmap_set(imem->pool.used, pos, npages);
+		imem->stats.pool++;
+	} else {
+		pos = ~0UL;
+	}
+	mutex_unlock(&imem->lock);
+
+	if (pos == ~0UL)
+		return NULL;
+
+	node->r.type = imem->pool.mn->type;
+	node->r.offset = imem->pool.mn->offset + pos;
+	node->r.length = npages;
+	return &node->r;
+}
+
+static void
+gk20a_instmem_pool_put(struct gk20a_instmem *imem, struct nvkm_mm_node *r)
+{
+	mutex_lock(&imem->lock);
+	bitmap_clear(imem->pool.used, r->offset - imem->pool.mn->offset,
+		     r->length);
+	mutex_unlock(&imem->lock);
+}
+
 static void *
 gk20a_instobj_dtor_iommu(struct nvkm_memory *memory)
 {
@@ -331,19 +422,24 @@ gk20a_instobj_dtor_iommu(struct nvkm_memory *memory)
 	/* clear IOMMU bit to unmap pages */
 	r->offset &= ~BIT(imem->iommu_bit - imem->iommu_pgshift);
 
-	/* Unmap pages from GPU address space and free them */
-	for (i = 0; i < node->base.mn->length; i++) {
-		iommu_unmap(imem->domain,
-			    (r->offset + i) << imem->iommu_pgshift, PAGE_SIZE);
+	/* Unmap pages from GPU address space, and free them */
+	iommu_unmap(imem->domain, (unsigned long)r->offset << imem->iommu_pgshift,
+		    (size_t)r->length << PAGE_SHIFT);
+
+	for (i = 0; i < r->length; i++) {
 		dma_unmap_page(dev, node->dma_addrs[i], PAGE_SIZE,
 			       DMA_BIDIRECTIONAL);
 		__free_page(node->pages[i]);
 	}
 
 	/* Release area from GPU address space */
-	mutex_lock(imem->mm_mutex);
-	nvkm_mm_free(imem->mm, &r);
-	mutex_unlock(imem->mm_mutex);
+	if (r == &node->r) {
+		gk20a_instmem_pool_put(imem, r);
+	} else {
+		mutex_lock(imem->mm_mutex);
+		nvkm_mm_free(imem->mm, &r);
+		mutex_unlock(imem->mm_mutex);
+	}
 
 out:
 	return node;
@@ -373,10 +469,67 @@ gk20a_instobj_func_iommu = {
 	.map = gk20a_instobj_map,
 };
 
+static u64
+gk20a_instobj_rd64(struct nvkm_memory *memory, u64 offset)
+{
+	struct gk20a_instobj *node = gk20a_instobj(memory);
+
+	return *(u64 *)((u8 *)node->vaddr + offset);
+}
+
+static void
+gk20a_instobj_wr64(struct nvkm_memory *memory, u64 offset, u64 data)
+{
+	struct gk20a_instobj *node = gk20a_instobj(memory);
+
+	*(u64 *)((u8 *)node->vaddr + offset) = data;
+}
+
+static void
+gk20a_instobj_copy_to(struct nvkm_memory *memory, u64 offset,
+		      const void *src, u64 size)
+{
+	struct gk20a_instobj *node = gk20a_instobj(memory);
+
+	memcpy((u8 *)node->vaddr + offset, src, size);
+}
+
+static void
+gk20a_instobj_copy_from(struct nvkm_memory *memory, u64 offset,
+			void *dst, u64 size)
+{
+	struct gk20a_instobj *node = gk20a_instobj(memory);
+
+	memcpy(dst, (u8 *)node->vaddr + offset, size);
+}
+
+static void
+gk20a_instobj_fill(struct nvkm_memory *memory, u64 offset, u32 data, u64 size)
+{
+	struct gk20a_instobj *node = gk20a_instobj(memory);
+	u64 *ptr = (u64 *)((u8 *)node->vaddr + offset);
+	u64 data64 = data | (u64)data << 32;
+
+	if (!data) {
+		memset(ptr, 0x00, size);
+		return;
+	}
+
+	for (; size >= 8; size -= 8)
+		*ptr++ = data64;
+	if (size >= 4)
+		*(u32 *)ptr = data;
+}
+
 static const struct nvkm_memory_ptrs
 gk20a_instobj_ptrs = {
 	.rd32 = gk20a_instobj_rd32,
 	.wr32 = gk20a_instobj_wr32,
+	.rd64 = gk20a_instobj_rd64,
+	.wr64 = gk20a_instobj_wr64,
+	.copy_to = gk20a_instobj_copy_to,
+	.copy_from = gk20a_instobj_copy_from,
+	.fill = gk20a_instobj_fill,
 };
 
 static int
@@ -425,8 +578,9 @@ gk20a_instobj_ctor_iommu(struct gk20a_instmem *imem, u32 npages, u32 align,
 	struct nvkm_subdev *subdev = &imem->base.subdev;
 	struct device *dev = subdev->device->dev;
 	struct nvkm_mm_node *r;
+	unsigned int order;
 	int ret;
-	int i;
+	int i, j;
 
 	/*
 	 * despite their variable size, instmem allocations are small enough
@@ -441,50 +595,86 @@ gk20a_instobj_ctor_iommu(struct gk20a_instmem *imem, u32 npages, u32 align,
 	nvkm_memory_ctor(&gk20a_instobj_func_iommu, &node->base.memory);
 	node->base.memory.ptrs = &gk20a_instobj_ptrs;
 
-	/* Allocate backing memory */
-	for (i = 0; i < npages; i++) {
-		struct page *p = alloc_page(GFP_KERNEL);
-		dma_addr_t dma_adr;
+	/* Allocate backing memory, in physically-contiguous chunks where
+	 * that's cheap, so the IOMMU mappings can be made in fewer pieces.
+	 */
+	for (i = 0; i < npages; i += 1 << order) {
+		struct page *p = NULL;
+
+		order = min_t(unsigned int, order_base_2(npages - i),
+			      GK20A_INSTOBJ_MAX_ORDER);
+		while (order && (1 << order) > npages - i)
+			order--;
+
+		for (; order && !p; order--) {
+			p = alloc_pages(GFP_KERNEL | __GFP_NORETRY |
+					__GFP_NOWARN, order);
+			if (p) {
+				split_page(p, order);
+				break;
+			}
+		}
 
-		if (p == NULL) {
+		if (!p && !(p = alloc_page(GFP_KERNEL))) {
 			ret = -ENOMEM;
 			goto free_pages;
 		}
-		node->pages[i] = p;
-		dma_adr = dma_map_page(dev, p, 0, PAGE_SIZE, DMA_BIDIRECTIONAL);
-		if (dma_mapping_error(dev, dma_adr)) {
-			nvkm_error(subdev, "DMA mapping error!\n");
-			ret = -ENOMEM;
-			goto free_pages;
+
+		for (j = 0; j < (1 << order); j++)
+			node->pages[i + j] = nth_page(p, j);
+
+		for (j = 0; j < (1 << order); j++) {
+			dma_addr_t dma_adr = dma_map_page(dev, node->pages[i + j],
+							  0, PAGE_SIZE,
+							  DMA_BIDIRECTIONAL);
+			if (dma_mapping_error(dev, dma_adr)) {
+				nvkm_error(subdev, "DMA mapping error!\n");
+				ret = -ENOMEM;
+				goto free_pages;
+			}
+			node->dma_addrs[i + j] = dma_adr;
 		}
-		node->dma_addrs[i] = dma_adr;
 	}
 
-	mutex_lock(imem->mm_mutex);
 	/* Reserve area from GPU address space */
-	ret = nvkm_mm_head(imem->mm, 0, 1, npages, npages,
-			   align >> imem->iommu_pgshift, &r);
-	mutex_unlock(imem->mm_mutex);
-	if (ret) {
-		nvkm_error(subdev, "IOMMU space is full!\n");
-		goto free_pages;
+	r = gk20a_instmem_pool_get(imem, node, npages, align);
+	if (!r) {
+		mutex_lock(imem->mm_mutex);
+		ret = nvkm_mm_head(imem->mm, 0, 1, npages, npages,
+				   align >> imem->iommu_pgshift, &r);
+		if (ret == 0)
+			imem->stats.mm++;
+		mutex_unlock(imem->mm_mutex);
+		if (ret) {
+			nvkm_error(subdev, "IOMMU space is full!\n");
+			goto free_pages;
+		}
 	}
 
-	/* Map into GPU address space */
-	for (i = 0; i < npages; i++) {
-		u32 offset = (r->offset + i) << imem->iommu_pgshift;
+	/* Map into GPU address space, a contiguous run of pages at a time */
+	for (i = 0; i < npages; i += j) {
+		unsigned long offset = (unsigned long)(r->offset + i) <<
+				       imem->iommu_pgshift;
+
+		for (j = 1; i + j < npages; j++) {
+			if (node->dma_addrs[i + j] !=
+			    node->dma_addrs[i] + j * PAGE_SIZE)
+				break;
+		}
 
 		ret = iommu_map(imem->domain, offset, node->dma_addrs[i],
-				PAGE_SIZE, IOMMU_READ | IOMMU_WRITE);
+				j * PAGE_SIZE, IOMMU_READ | IOMMU_WRITE);
 		if (ret < 0) {
 			nvkm_error(subdev, "IOMMU mapping failure: %d\n", ret);
-
-			while (i-- > 0) {
-				offset -= PAGE_SIZE;
-				iommu_unmap(imem->domain, offset, PAGE_SIZE);
+			if (i) {
+				iommu_unmap(imem->domain, (unsigned long)
+					    r->offset << imem->iommu_pgshift,
+					    i * PAGE_SIZE);
 			}
 			goto release_area;
 		}
+
+		imem->stats.iommu_map++;
 	}
 
 	/* IOMMU bit tells that an address is to be resolved through the IOMMU */
@@ -494,9 +684,13 @@ gk20a_instobj_ctor_iommu(struct gk20a_instmem *imem, u32 npages, u32 align,
 	return 0;
 
 release_area:
-	mutex_lock(imem->mm_mutex);
-	nvkm_mm_free(imem->mm, &r);
-	mutex_unlock(imem->mm_mutex);
+	if (r == &node->r) {
+		gk20a_instmem_pool_put(imem, r);
+	} else {
+		mutex_lock(imem->mm_mutex);
+		nvkm_mm_free(imem->mm, &r);
+		mutex_unlock(imem->mm_mutex);
+	}
 
 free_pages:
 	for (i = 0; i < npages && node->pages[i] != NULL; i++) {
@@ -544,11 +738,56 @@ gk20a_instobj_new(struct nvkm_instmem *base, u32 size, u32 align, bool zero,
 	return 0;
 }
 
+static void
+gk20a_instmem_pool_init(struct gk20a_instmem *imem)
+{
+	const u32 pages = GK20A_INSTMEM_POOL_SIZE >> imem->iommu_pgshift;
+	int ret;
+
+	imem->pool.used = kcalloc(BITS_TO_LONGS(pages), sizeof(long),
+				  GFP_KERNEL);
+	if (!imem->pool.used)
+		return;
+
+	mutex_lock(imem->mm_mutex);
+	ret = nvkm_mm_head(imem->mm, 0, 1, pages, pages,
+			   GK20A_INSTMEM_POOL_ALIGN >> imem->iommu_pgshift,
+			   &imem->pool.mn);
+	mutex_unlock(imem->mm_mutex);
+	if (ret) {
+		nvkm_warn(&imem->base.subdev, "IOMMU pool unavailable: %d\n",
+			  ret);
+		kfree(imem->pool.used);
+		imem->pool.used = NULL;
+		return;
+	}
+
+	imem->pool.pages = pages;
+}
+
 static void *
 gk20a_instmem_dtor(struct nvkm_instmem *base)
 {
 	struct gk20a_instmem *imem = gk20a_instmem(base);
 
+	nvkm_debug(&base->subdev, "vaddr: %lld hits, %lld maps, "
+				  "%lld evictions, %x/%x peak/max\n",
+		   imem->stats.vaddr_hit, imem->stats.vaddr_map,
+		   imem->stats.vaddr_evict, imem->vaddr_peak, imem->vaddr_max);
+	if (imem->domain) {
+		nvkm_debug(&base->subdev, "iommu: %lld pool, %lld mm objects, "
+					  "%lld map calls\n",
+			   imem->stats.pool, imem->stats.mm,
+			   imem->stats.iommu_map);
+	}
+
+	if (imem->pool.mn) {
+		mutex_lock(imem->mm_mutex);
+		nvkm_mm_free(imem->mm, &imem->pool.mn);
+		mutex_unlock(imem->mm_mutex);
+	}
+	kfree(imem->pool.used);
+
 	/* perform some sanity checks... */
 	if (!list_empty(&imem->vaddr_lru))
 		nvkm_warn(&base->subdev, "instobj LRU not empty!\n");
@@ -565,6 +804,7 @@ gk20a_instmem = {
 	.dtor = gk20a_instmem_dtor,
 	.memory_new = gk20a_instobj_new,
 	.zero = false,
+	.persistent = true,
 };
 
 int
@@ -580,9 +820,9 @@ gk20a_instmem_new(struct nvkm_device *device, int index,
 	mutex_init(&imem->lock);
 	*pimem = &imem->base;
 
-	/* do not allow more than 1MB of CPU-mapped instmem */
+	/* CPU-mapped instmem limit, adjusted according to use */
 	imem->vaddr_use = 0;
-	imem->vaddr_max = 0x100000;
+	imem->vaddr_max = GK20A_INSTMEM_VADDR_MIN;
 	INIT_LIST_HEAD(&imem->vaddr_lru);
 
 	if (tdev->iommu.domain) {
@@ -591,6 +831,7 @@ gk20a_instmem_new(struct nvkm_device *device, int index,
 		imem->domain = tdev->iommu.domain;
 		imem->iommu_pgshift = tdev->iommu.pgshift;
 		imem->iommu_bit = tdev->func->iommu_bit;
+		gk20a_instmem_pool_init(imem);
 
 		nvkm_info(&imem->base.subdev, "using IOMMU\n");
 	} else {
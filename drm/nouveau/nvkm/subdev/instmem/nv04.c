@@ -58,10 +58,60 @@ nv04_instobj_rd32(struct nvkm_memory *memory, u64 offset)
 	return nvkm_rd32(device, 0x700000 + iobj->node->offset + offset);
 }
 
+static void __iomem *
+nv04_instobj_ptr(struct nvkm_memory *memory, u64 offset)
+{
+	struct nv04_instobj *iobj = nv04_instobj(memory);
+	return iobj->imem->base.subdev.device->pri + 0x700000 + iobj->node->offset + offset;
+}
+
+/* PRAMIN is accessed through BAR0, which must only see 32-bit accesses. */
+static void
+nv04_instobj_copy_to(struct nvkm_memory *memory, u64 offset,
+		     const void *src, u64 size)
+{
+	void __iomem *map = nv04_instobj_ptr(memory, offset);
+	u64 i;
+
+	for (i = 0; i < size; i += 4) {
+		u32 data;
+		if (unlikely(size - i < 4))
+			data = ioread32_native(map + i);
+		memcpy(&data, src + i, min_t(u64, size - i, 4));
+		iowrite32_native(data, map + i);
+	}
+}
+
+static void
+nv04_instobj_copy_from(struct nvkm_memory *memory, u64 offset,
+		       void *dst, u64 size)
+{
+	void __iomem *map = nv04_instobj_ptr(memory, offset);
+	u64 i;
+
+	for (i = 0; i < size; i += 4) {
+		u32 data = ioread32_native(map + i);
+		memcpy(dst + i, &data, min_t(u64, size - i, 4));
+	}
+}
+
+static void
+nv04_instobj_fill(struct nvkm_memory *memory, u64 offset, u32 data, u64 size)
+{
+	void __iomem *map = nv04_instobj_ptr(memory, offset);
+	u64 i;
+
+	for (i = 0; i < size; i += 4)
+		iowrite32_native(data, map + i);
+}
+
 static const struct nvkm_memory_ptrs
 nv04_instobj_ptrs = {
 	.rd32 = nv04_instobj_rd32,
 	.wr32 = nv04_instobj_wr32,
+	.copy_to = nv04_instobj_copy_to,
+	.copy_from = nv04_instobj_copy_from,
+	.fill = nv04_instobj_fill,
 };
 
 static void
@@ -58,10 +58,55 @@ nv40_instobj_rd32(struct nvkm_memory *memory, u64 offset)
 	return ioread32_native(iobj->imem->iomem + iobj->node->offset + offset);
 }
 
+static void __iomem *
+nv40_instobj_ptr(struct nvkm_memory *memory, u64 offset)
+{
+	struct nv40_instobj *iobj = nv40_instobj(memory);
+	return iobj->imem->iomem + iobj->node->offset + offset;
+}
+
+static void
+nv40_instobj_wr64(struct nvkm_memory *memory, u64 offset, u64 data)
+{
+	iowrite64_native(data, nv40_instobj_ptr(memory, offset));
+}
+
+static u64
+nv40_instobj_rd64(struct nvkm_memory *memory, u64 offset)
+{
+	return ioread64_native(nv40_instobj_ptr(memory, offset));
+}
+
+static void
+nv40_instobj_copy_to(struct nvkm_memory *memory, u64 offset,
+		     const void *src, u64 size)
+{
+	memcpy_toio(nv40_instobj_ptr(memory, offset), src, size);
+}
+
+static void
+nv40_instobj_copy_from(struct nvkm_memory *memory, u64 offset,
+		       void *dst, u64 size)
+{
+	memcpy_fromio(dst, nv40_instobj_ptr(memory, offset), size);
+}
+
+static void
+nv40_instobj_fill(struct nvkm_memory *memory, u64 offset, u32 data, u64 size)
+{
+	nvkm_memory_fill_io(nv40_instobj_ptr(memory, offset),
+			    data | (u64)data << 32, size);
+}
+
 static const struct nvkm_memory_ptrs
 nv40_instobj_ptrs = {
 	.rd32 = nv40_instobj_rd32,
 	.wr32 = nv40_instobj_wr32,
+	.rd64 = nv40_instobj_rd64,
+	.wr64 = nv40_instobj_wr64,
+	.copy_to = nv40_instobj_copy_to,
+	.copy_from = nv40_instobj_copy_from,
+	.fill = nv40_instobj_fill,
 };
 
 static void
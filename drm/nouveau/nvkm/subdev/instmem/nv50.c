@@ -33,10 +33,193 @@ struct nv50_instmem {
 	struct nvkm_instmem base;
 	u64 addr;
 
+	/* BAR2 mappings of VRAM, shared by the objects they cover. */
+	struct list_head slabs;
+
 	/* Mappings that can be evicted when BAR2 space has been exhausted. */
 	struct list_head lru;
+
+	u64 mapped; /* Slabs mapped into BAR2. */
+	u64 evicted; /* Slabs evicted to make room for another. */
+};
+
+/******************************************************************************
+ * BAR2 slab implementation
+ *****************************************************************************/
+#define nv50_instslab(p) container_of((p), struct nv50_instslab, memory)
+
+/* Objects that fit inside an aligned 1MiB window of VRAM share a single
+ * BAR2 mapping of the entire window, anything larger gets its own.
+ */
+#define NV50_INSTSLAB_SIZE 0x100000ULL
+
+struct nv50_instslab {
+	struct nvkm_memory memory;
+	struct nvkm_mm_node mn;
+	bool shared;
+	bool pinned; /* Bootstrapped, never evicted. */
+
+	struct list_head head; /* nv50_instmem.slabs */
+	struct list_head lru; /* nv50_instmem.lru, when there's no users. */
+	struct list_head iobjs; /* Objects accessed through the slab. */
+	int users; /* Objects currently acquired. */
+
+	struct nvkm_vma *bar;
+	void *map;
 };
 
+static int
+nv50_instslab_map(struct nvkm_memory *memory, u64 offset, struct nvkm_vmm *vmm,
+		  struct nvkm_vma *vma, void *argv, u32 argc)
+{
+	struct nv50_instslab *slab = nv50_instslab(memory);
+	struct nvkm_vmm_map map = {
+		.memory = &slab->memory,
+		.offset = offset,
+		.mem = &slab->mn,
+	};
+
+	return nvkm_vmm_map(vmm, vma, argv, argc, &map);
+}
+
+static u64
+nv50_instslab_size(struct nvkm_memory *memory)
+{
+	return (u64)nv50_instslab(memory)->mn.length << NVKM_RAM_MM_SHIFT;
+}
+
+static u64
+nv50_instslab_addr(struct nvkm_memory *memory)
+{
+	return (u64)nv50_instslab(memory)->mn.offset << NVKM_RAM_MM_SHIFT;
+}
+
+static u8
+nv50_instslab_page(struct nvkm_memory *memory)
+{
+	return 12;
+}
+
+static enum nvkm_memory_target
+nv50_instslab_target(struct nvkm_memory *memory)
+{
+	return NVKM_MEM_TARGET_VRAM;
+}
+
+static void *
+nv50_instslab_dtor(struct nvkm_memory *memory)
+{
+	return nv50_instslab(memory);
+}
+
+static const struct nvkm_memory_func
+nv50_instslab_func = {
+	.dtor = nv50_instslab_dtor,
+	.target = nv50_instslab_target,
+	.page = nv50_instslab_page,
+	.addr = nv50_instslab_addr,
+	.size = nv50_instslab_size,
+	.map = nv50_instslab_map,
+};
+
+static void
+nv50_instslab_del(struct nvkm_vmm *vmm, struct nv50_instslab **pslab)
+{
+	struct nv50_instslab *slab = *pslab;
+	if (slab) {
+		struct nvkm_memory *memory = &slab->memory;
+		if (slab->map)
+			iounmap(slab->map);
+		if (likely(vmm)) /* NULL once BAR2 is gone. */
+			nvkm_vmm_put(vmm, &slab->bar);
+		nvkm_memory_unref(&memory);
+		*pslab = NULL;
+	}
+}
+
+static void nv50_instobj_unmap(struct nv50_instslab *);
+
+static struct nv50_instslab *
+nv50_instslab_new(struct nv50_instmem *imem, struct nvkm_vmm *vmm,
+		  u64 addr, u64 size, bool shared)
+{
+	struct nvkm_subdev *subdev = &imem->base.subdev;
+	struct nvkm_device *device = subdev->device;
+	struct nv50_instslab *slab, *eslab;
+	struct nvkm_vma *bar = NULL;
+	void *map = NULL;
+	int ret;
+
+	if (!(slab = kzalloc(sizeof(*slab), GFP_KERNEL)))
+		return NULL;
+
+	nvkm_memory_ctor(&nv50_instslab_func, &slab->memory);
+	slab->mn.offset = addr >> NVKM_RAM_MM_SHIFT;
+	slab->mn.length = size >> NVKM_RAM_MM_SHIFT;
+	slab->shared = shared;
+	INIT_LIST_HEAD(&slab->lru);
+	INIT_LIST_HEAD(&slab->iobjs);
+
+	/* Make the slab visible before dropping the lock, so that other
+	 * objects in the same window don't try and map it too.  They'll
+	 * use the slow path until the mapping is ready.
+	 */
+	list_add_tail(&slab->head, &imem->slabs);
+
+	/* Attempt to allocate BAR2 address-space and map the slab into
+	 * it.  The lock has to be dropped while doing this due to the
+	 * possibility of recursion for page table allocation.
+	 */
+	mutex_unlock(&subdev->mutex);
+	while ((ret = nvkm_vmm_get(vmm, 12, size, &bar))) {
+		/* Evict unused slabs, and keep retrying until we either
+		 * succeed, or there's no more slabs left on the LRU.
+		 */
+		mutex_lock(&subdev->mutex);
+		eslab = list_first_entry_or_null(&imem->lru, typeof(*eslab), lru);
+		if (eslab) {
+			nvkm_debug(subdev, "evict %016llx %016llx @ %016llx\n",
+				   nvkm_memory_addr(&eslab->memory),
+				   nvkm_memory_size(&eslab->memory),
+				   eslab->bar->addr);
+			list_del_init(&eslab->lru);
+			list_del(&eslab->head);
+			nv50_instobj_unmap(eslab);
+			imem->evicted++;
+		}
+		mutex_unlock(&subdev->mutex);
+		if (!eslab)
+			break;
+		nv50_instslab_del(vmm, &eslab);
+	}
+
+	if (ret == 0)
+		ret = nvkm_memory_map(&slab->memory, 0, vmm, bar, NULL, 0);
+	if (ret == 0) {
+		/* Make the mapping visible to the host. */
+		map = ioremap_wc(device->func->resource_addr(device, 3) +
+				 (u32)bar->addr, size);
+		if (!map) {
+			nvkm_warn(subdev, "PRAMIN ioremap failed\n");
+			ret = -ENOMEM;
+		}
+	}
+
+	slab->bar = bar;
+	slab->map = map;
+	mutex_lock(&subdev->mutex);
+	if (ret) {
+		list_del(&slab->head);
+		mutex_unlock(&subdev->mutex);
+		nv50_instslab_del(vmm, &slab);
+		mutex_lock(&subdev->mutex);
+		return NULL;
+	}
+
+	imem->mapped++;
+	return slab;
+}
+
 /******************************************************************************
  * instmem object implementation
  *****************************************************************************/
@@ -46,12 +229,123 @@ struct nv50_instobj {
 	struct nvkm_instobj base;
 	struct nv50_instmem *imem;
 	struct nvkm_memory *ram;
-	struct nvkm_vma *bar;
+	struct nv50_instslab *slab;
+	struct list_head slab_head; /* nv50_instslab.iobjs */
 	refcount_t maps;
 	void *map;
-	struct list_head lru;
 };
 
+/* Bulk accessors for the PRAMIN path.  Accesses are split at 1MiB window
+ * boundaries (and into bounded chunks, to limit the time spent with the
+ * lock held), so the window register is only touched on crossing, and
+ * the lock is taken once per chunk rather than per-dword.
+ */
+#define NV50_INSTOBJ_SLOW_CHUNK 0x10000
+
+static u32
+nv50_instobj_slow_window(struct nv50_instmem *imem, u64 addr, u64 *size)
+{
+	struct nvkm_device *device = imem->base.subdev.device;
+	u64 base = addr & 0xffffff00000ULL;
+
+	*size = min_t(u64, *size, 0x100000 - (addr & 0x000000fffffULL));
+	*size = min_t(u64, *size, NV50_INSTOBJ_SLOW_CHUNK);
+	if (unlikely(imem->addr != base)) {
+		nvkm_wr32(device, 0x001700, base >> 16);
+		imem->addr = base;
+	}
+	return 0x700000 + (addr & 0x000000fffffULL);
+}
+
+static void
+nv50_instmem_xfer_rd(struct nvkm_device *device, u32 pramin,
+		     void *dst, u64 size)
+{
+	void __iomem *src = device->pri + pramin;
+	u64 tail = size & ~3ULL;
+	u32 data;
+
+	__ioread32_copy(dst, src, tail / 4);
+	if (unlikely(size & 3)) {
+		data = ioread32_native(src + tail);
+		memcpy(dst + tail, &data, size & 3);
+	}
+}
+
+static void
+nv50_instmem_xfer_wr(struct nvkm_device *device, u32 pramin,
+		     const void *src, u64 size)
+{
+	void __iomem *dst = device->pri + pramin;
+	u64 tail = size & ~3ULL;
+	u32 data;
+
+	__iowrite32_copy(dst, src, tail / 4);
+	if (unlikely(size & 3)) {
+		data = ioread32_native(dst + tail);
+		memcpy(&data, src + tail, size & 3);
+		iowrite32_native(data, dst + tail);
+	}
+}
+
+static int
+nv50_instmem_xfer_cmp(const void *a, const void *b)
+{
+	const struct nvkm_instmem_xfer *xa = a, *xb = b;
+	u64 aa = nvkm_memory_addr(xa->memory) + xa->offset;
+	u64 ab = nvkm_memory_addr(xb->memory) + xb->offset;
+
+	return aa < ab ? -1 : aa > ab;
+}
+
+/* Batches are sorted by VRAM address so that accesses sharing a window
+ * are done together, and the lock is held across them, only dropping it
+ * every NV50_INSTOBJ_SLOW_CHUNK bytes to bound IRQ-off time.
+ */
+static void
+nv50_instmem_xfer(struct nvkm_instmem *base,
+		  struct nvkm_instmem_xfer *xfer, int nr)
+{
+	struct nv50_instmem *imem = nv50_instmem(base);
+	struct nvkm_device *device = imem->base.subdev.device;
+	unsigned long flags;
+	u64 addr, size, len, held = 0;
+	void *data;
+	u32 pramin;
+	int i;
+
+	if (nr > 1)
+		sort(xfer, nr, sizeof(*xfer), nv50_instmem_xfer_cmp, NULL);
+
+	spin_lock_irqsave(&imem->base.lock, flags);
+	for (i = 0; i < nr; i++) {
+		addr = nvkm_memory_addr(xfer[i].memory) + xfer[i].offset;
+		size = xfer[i].size;
+		data = xfer[i].data;
+
+		while (size) {
+			if (held == NV50_INSTOBJ_SLOW_CHUNK) {
+				spin_unlock_irqrestore(&imem->base.lock, flags);
+				spin_lock_irqsave(&imem->base.lock, flags);
+				held = 0;
+			}
+
+			len = min_t(u64, size, NV50_INSTOBJ_SLOW_CHUNK - held);
+			pramin = nv50_instobj_slow_window(imem, addr, &len);
+			if (xfer[i].write)
+				nv50_instmem_xfer_wr(device, pramin, data, len);
+			else
+				nv50_instmem_xfer_rd(device, pramin, data, len);
+
+			held += len;
+			addr += len;
+			data += len;
+			size -= len;
+		}
+	}
+	spin_unlock_irqrestore(&imem->base.lock, flags);
+}
+
 static void
 nv50_instobj_wr32_slow(struct nvkm_memory *memory, u64 offset, u32 data)
 {
@@ -92,10 +386,66 @@ nv50_instobj_rd32_slow(struct nvkm_memory *memory, u64 offset)
 	return data;
 }
 
+static void
+nv50_instobj_copy_to_slow(struct nvkm_memory *memory, u64 offset,
+			  const void *src, u64 size)
+{
+	struct nvkm_instmem_xfer xfer = {
+		.memory = memory,
+		.offset = offset,
+		.size = size,
+		.data = (void *)src,
+		.write = true,
+	};
+
+	nv50_instmem_xfer(&nv50_instobj(memory)->imem->base, &xfer, 1);
+}
+
+static void
+nv50_instobj_copy_from_slow(struct nvkm_memory *memory, u64 offset,
+			    void *dst, u64 size)
+{
+	struct nvkm_instmem_xfer xfer = {
+		.memory = memory,
+		.offset = offset,
+		.size = size,
+		.data = dst,
+	};
+
+	nv50_instmem_xfer(&nv50_instobj(memory)->imem->base, &xfer, 1);
+}
+
+static void
+nv50_instobj_fill_slow(struct nvkm_memory *memory, u64 offset,
+		       u32 data, u64 size)
+{
+	struct nv50_instobj *iobj = nv50_instobj(memory);
+	struct nv50_instmem *imem = iobj->imem;
+	struct nvkm_device *device = imem->base.subdev.device;
+	u64 addr = nvkm_memory_addr(iobj->ram) + offset;
+	unsigned long flags;
+	u64 len, i;
+	u32 pramin;
+
+	while (size) {
+		spin_lock_irqsave(&imem->base.lock, flags);
+		len = size;
+		pramin = nv50_instobj_slow_window(imem, addr, &len);
+		for (i = 0; i < len; i += 4)
+			nvkm_wr32(device, pramin + i, data);
+		spin_unlock_irqrestore(&imem->base.lock, flags);
+		addr += len;
+		size -= len;
+	}
+}
+
 static const struct nvkm_memory_ptrs
 nv50_instobj_slow = {
 	.rd32 = nv50_instobj_rd32_slow,
 	.wr32 = nv50_instobj_wr32_slow,
+	.copy_to = nv50_instobj_copy_to_slow,
+	.copy_from = nv50_instobj_copy_from_slow,
+	.fill = nv50_instobj_fill_slow,
 };
 
 static void
@@ -110,73 +460,109 @@ nv50_instobj_rd32(struct nvkm_memory *memory, u64 offset)
 	return ioread32_native(nv50_instobj(memory)->map + offset);
 }
 
+static void
+nv50_instobj_wr64(struct nvkm_memory *memory, u64 offset, u64 data)
+{
+	iowrite64_native(data, nv50_instobj(memory)->map + offset);
+}
+
+static u64
+nv50_instobj_rd64(struct nvkm_memory *memory, u64 offset)
+{
+	return ioread64_native(nv50_instobj(memory)->map + offset);
+}
+
+static void
+nv50_instobj_copy_to(struct nvkm_memory *memory, u64 offset,
+		     const void *src, u64 size)
+{
+	memcpy_toio(nv50_instobj(memory)->map + offset, src, size);
+}
+
+static void
+nv50_instobj_copy_from(struct nvkm_memory *memory, u64 offset,
+		       void *dst, u64 size)
+{
+	memcpy_fromio(dst, nv50_instobj(memory)->map + offset, size);
+}
+
+static void
+nv50_instobj_fill(struct nvkm_memory *memory, u64 offset, u32 data, u64 size)
+{
+	nvkm_memory_fill_io(nv50_instobj(memory)->map + offset,
+			    data | (u64)data << 32, size);
+}
+
 static const struct nvkm_memory_ptrs
 nv50_instobj_fast = {
 	.rd32 = nv50_instobj_rd32,
 	.wr32 = nv50_instobj_wr32,
+	.rd64 = nv50_instobj_rd64,
+	.wr64 = nv50_instobj_wr64,
+	.copy_to = nv50_instobj_copy_to,
+	.copy_from = nv50_instobj_copy_from,
+	.fill = nv50_instobj_fill,
 };
 
+/* Detach all objects from a slab that's being evicted. */
+static void
+nv50_instobj_unmap(struct nv50_instslab *slab)
+{
+	struct nv50_instobj *iobj, *temp;
+
+	list_for_each_entry_safe(iobj, temp, &slab->iobjs, slab_head) {
+		list_del_init(&iobj->slab_head);
+		iobj->slab = NULL;
+		iobj->map = NULL;
+	}
+}
+
 static void
 nv50_instobj_kmap(struct nv50_instobj *iobj, struct nvkm_vmm *vmm)
 {
 	struct nv50_instmem *imem = iobj->imem;
-	struct nv50_instobj *eobj;
 	struct nvkm_memory *memory = &iobj->base.memory;
-	struct nvkm_subdev *subdev = &imem->base.subdev;
-	struct nvkm_device *device = subdev->device;
-	struct nvkm_vma *bar = NULL, *ebar;
+	struct nvkm_device *device = imem->base.subdev.device;
+	struct nv50_instslab *slab;
+	u64 addr = nvkm_memory_addr(memory);
 	u64 size = nvkm_memory_size(memory);
-	void *emap;
-	int ret;
+	u64 base = addr & ~(NV50_INSTSLAB_SIZE - 1);
+	bool shared = addr + size <= base + NV50_INSTSLAB_SIZE;
+
+	if (shared) {
+		addr = base;
+		size = min_t(u64, NV50_INSTSLAB_SIZE, device->fb->ram->size - base);
+	}
 
-	/* Attempt to allocate BAR2 address-space and map the object
-	 * into it.  The lock has to be dropped while doing this due
-	 * to the possibility of recursion for page table allocation.
+	/* The lock is dropped while a slab is being mapped, so another
+	 * thread may already be mapping the object's own slab as well as
+	 * a shared one.
 	 */
-	mutex_unlock(&subdev->mutex);
-	while ((ret = nvkm_vmm_get(vmm, 12, size, &bar))) {
-		/* Evict unused mappings, and keep retrying until we either
-		 * succeed,or there's no more objects left on the LRU.
-		 */
-		mutex_lock(&subdev->mutex);
-		eobj = list_first_entry_or_null(&imem->lru, typeof(*eobj), lru);
-		if (eobj) {
-			nvkm_debug(subdev, "evict %016llx %016llx @ %016llx\n",
-				   nvkm_memory_addr(&eobj->base.memory),
-				   nvkm_memory_size(&eobj->base.memory),
-				   eobj->bar->addr);
-			list_del_init(&eobj->lru);
-			ebar = eobj->bar;
-			eobj->bar = NULL;
-			emap = eobj->map;
-			eobj->map = NULL;
-		}
-		mutex_unlock(&subdev->mutex);
-		if (!eobj)
-			break;
-		iounmap(emap);
-		nvkm_vmm_put(vmm, &ebar);
+	list_for_each_entry(slab, &imem->slabs, head) {
+		if (slab->shared == shared &&
+		    nvkm_memory_addr(&slab->memory) == addr)
+			goto found;
 	}
 
-	if (ret == 0)
-		ret = nvkm_memory_map(memory, 0, vmm, bar, NULL, 0);
-	mutex_lock(&subdev->mutex);
-	if (ret || iobj->bar) {
-		/* We either failed, or another thread beat us. */
-		mutex_unlock(&subdev->mutex);
-		nvkm_vmm_put(vmm, &bar);
-		mutex_lock(&subdev->mutex);
+	slab = nv50_instslab_new(imem, vmm, addr, size, shared);
+	if (!slab)
 		return;
-	}
 
-	/* Make the mapping visible to the host. */
-	iobj->bar = bar;
-	iobj->map = ioremap_wc(device->func->resource_addr(device, 3) +
-			       (u32)iobj->bar->addr, size);
-	if (!iobj->map) {
-		nvkm_warn(subdev, "PRAMIN ioremap failed\n");
-		nvkm_vmm_put(vmm, &iobj->bar);
-	}
+found:
+	/* Mapping still in progress, or another thread beat us. */
+	if (!slab->map || iobj->map)
+		return;
+
+	iobj->slab = slab;
+	iobj->map = slab->map + (nvkm_memory_addr(memory) -
+				 nvkm_memory_addr(&slab->memory));
+	list_add_tail(&iobj->slab_head, &slab->iobjs);
+
+	/* Another thread may have started accessing the object via the
+	 * slow path while we were mapping the slab.
+	 */
+	if (refcount_read(&iobj->maps) && !slab->users++)
+		list_del_init(&slab->lru);
 }
 
 static int
@@ -201,9 +587,9 @@ nv50_instobj_release(struct nvkm_memory *memory)
 		/* Add the now-unused mapping to the LRU instead of directly
 		 * unmapping it here, in case we need to map it again later.
 		 */
-		if (likely(iobj->lru.next) && iobj->map) {
-			BUG_ON(!list_empty(&iobj->lru));
-			list_add_tail(&iobj->lru, &imem->lru);
+		if (iobj->slab && !--iobj->slab->users && !iobj->slab->pinned) {
+			BUG_ON(!list_empty(&iobj->slab->lru));
+			list_add_tail(&iobj->slab->lru, &imem->lru);
 		}
 
 		/* Switch back to NULL accessors when last map is gone. */
@@ -241,9 +627,9 @@ nv50_instobj_acquire(struct nvkm_memory *memory)
 	}
 
 	if (!refcount_inc_not_zero(&iobj->maps)) {
-		/* Exclude object from eviction while it's being accessed. */
-		if (likely(iobj->lru.next))
-			list_del_init(&iobj->lru);
+		/* Exclude mapping from eviction while it's being accessed. */
+		if (iobj->slab && !iobj->slab->users++)
+			list_del_init(&iobj->slab->lru);
 
 		if (map)
 			iobj->base.memory.ptrs = &nv50_instobj_fast;
@@ -266,12 +652,12 @@ nv50_instobj_boot(struct nvkm_memory *memory, struct nvkm_vmm *vmm)
 	 * instmem BAR itself) from eviction.
 	 */
 	mutex_lock(&imem->subdev.mutex);
-	if (likely(iobj->lru.next)) {
-		list_del_init(&iobj->lru);
-		iobj->lru.next = NULL;
+	if (!iobj->map)
+		nv50_instobj_kmap(iobj, vmm);
+	if (iobj->slab) {
+		list_del_init(&iobj->slab->lru);
+		iobj->slab->pinned = true;
 	}
-
-	nv50_instobj_kmap(iobj, vmm);
 	nvkm_instmem_boot(imem);
 	mutex_unlock(&imem->subdev.mutex);
 }
@@ -299,21 +685,26 @@ nv50_instobj_dtor(struct nvkm_memory *memory)
 {
 	struct nv50_instobj *iobj = nv50_instobj(memory);
 	struct nvkm_instmem *imem = &iobj->imem->base;
-	struct nvkm_vma *bar;
-	void *map = map;
+	struct nv50_instslab *slab;
 
+	/* Slabs of other objects are kept around (on the LRU) for reuse,
+	 * but there's no point keeping an object's private mapping.
+	 */
 	mutex_lock(&imem->subdev.mutex);
-	if (likely(iobj->lru.next))
-		list_del(&iobj->lru);
-	map = iobj->map;
-	bar = iobj->bar;
+	if ((slab = iobj->slab)) {
+		list_del(&iobj->slab_head);
+		if (!slab->shared) {
+			list_del(&slab->lru);
+			list_del(&slab->head);
+		} else {
+			slab = NULL;
+		}
+	}
 	mutex_unlock(&imem->subdev.mutex);
 
-	if (map) {
+	if (slab) {
 		struct nvkm_vmm *vmm = nvkm_bar_bar2_vmm(imem->subdev.device);
-		iounmap(map);
-		if (likely(vmm)) /* Can be NULL during BAR destructor. */
-			nvkm_vmm_put(vmm, &bar);
+		nv50_instslab_del(vmm, &slab);
 	}
 
 	nvkm_memory_unref(&iobj->ram);
@@ -349,7 +740,7 @@ nv50_instobj_new(struct nvkm_instmem *base, u32 size, u32 align, bool zero,
 	nvkm_instobj_ctor(&nv50_instobj_func, &imem->base, &iobj->base);
 	iobj->imem = imem;
 	refcount_set(&iobj->maps, 0);
-	INIT_LIST_HEAD(&iobj->lru);
+	INIT_LIST_HEAD(&iobj->slab_head);
 
 	return nvkm_ram_get(device, 0, 1, page, size, true, true, &iobj->ram);
 }
@@ -364,9 +755,67 @@ nv50_instmem_fini(struct nvkm_instmem *base)
 	nv50_instmem(base)->addr = ~0ULL;
 }
 
+static void
+nv50_instmem_stat(struct nvkm_instmem *base, struct nvkm_subdev_stat *stat)
+{
+	struct nv50_instmem *imem = nv50_instmem(base);
+	nvkm_stat(stat, "bar2 slabs mapped", imem->mapped);
+	nvkm_stat(stat, "bar2 slabs evicted", imem->evicted);
+}
+
+static void
+nv50_instmem_bar2_fini(struct nvkm_instmem *base)
+{
+	struct nv50_instmem *imem = nv50_instmem(base);
+	struct nv50_instslab *slab;
+	struct nv50_instobj *iobj;
+
+	/* BAR2 is being destroyed.  Its VMM reclaims the address-space
+	 * backing the slabs itself, so only the CPU mappings are dropped
+	 * here, and the slabs freed later by the destructor.
+	 */
+	mutex_lock(&imem->base.subdev.mutex);
+	list_for_each_entry(slab, &imem->slabs, head) {
+		list_for_each_entry(iobj, &slab->iobjs, slab_head) {
+			if (refcount_read(&iobj->maps))
+				iobj->base.memory.ptrs = &nv50_instobj_slow;
+		}
+		nv50_instobj_unmap(slab);
+		list_del_init(&slab->lru);
+		if (slab->map) {
+			iounmap(slab->map);
+			slab->map = NULL;
+		}
+		slab->bar = NULL;
+	}
+	mutex_unlock(&imem->base.subdev.mutex);
+}
+
+static void *
+nv50_instmem_dtor(struct nvkm_instmem *base)
+{
+	struct nv50_instmem *imem = nv50_instmem(base);
+	struct nv50_instslab *slab, *temp;
+
+	nvkm_debug(&imem->base.subdev, "%lld slabs mapped, %lld evicted\n",
+		   imem->mapped, imem->evicted);
+
+	/* BAR is already gone, see nv50_instmem_bar2_fini(). */
+	list_for_each_entry_safe(slab, temp, &imem->slabs, head) {
+		list_del(&slab->head);
+		nv50_instslab_del(NULL, &slab);
+	}
+
+	return imem;
+}
+
 static const struct nvkm_instmem_func
 nv50_instmem = {
+	.dtor = nv50_instmem_dtor,
 	.fini = nv50_instmem_fini,
+	.bar2_fini = nv50_instmem_bar2_fini,
+	.stat = nv50_instmem_stat,
+	.xfer = nv50_instmem_xfer,
 	.memory_new = nv50_instobj_new,
 	.zero = false,
 };
@@ -380,6 +829,7 @@ nv50_instmem_new(struct nvkm_device *device, int index,
 	if (!(imem = kzalloc(sizeof(*imem), GFP_KERNEL)))
 		return -ENOMEM;
 	nvkm_instmem_ctor(&nv50_instmem, device, index, &imem->base);
+	INIT_LIST_HEAD(&imem->slabs);
 	INIT_LIST_HEAD(&imem->lru);
 	*pimem = &imem->base;
 	return 0;
@@ -3,15 +3,33 @@
 #define nvkm_instmem(p) container_of((p), struct nvkm_instmem, subdev)
 #include <subdev/instmem.h>
 
+/* A single access in a batch of slow-path transfers. */
+struct nvkm_instmem_xfer {
+	struct nvkm_memory *memory;
+	u64 offset;
+	u64 size;
+	void *data;
+	bool write;
+};
+
 struct nvkm_instmem_func {
 	void *(*dtor)(struct nvkm_instmem *);
 	int (*oneinit)(struct nvkm_instmem *);
 	void (*fini)(struct nvkm_instmem *);
+	/* BAR2 is about to be destroyed, drop any mappings through it. */
+	void (*bar2_fini)(struct nvkm_instmem *);
+	void (*stat)(struct nvkm_instmem *, struct nvkm_subdev_stat *);
 	u32  (*rd32)(struct nvkm_instmem *, u32 addr);
 	void (*wr32)(struct nvkm_instmem *, u32 addr, u32 data);
+	/* Batched access to objects without a direct mapping.  The batch
+	 * may be reordered by the implementation.
+	 */
+	void (*xfer)(struct nvkm_instmem *, struct nvkm_instmem_xfer *, int nr);
 	int (*memory_new)(struct nvkm_instmem *, u32 size, u32 align,
 			  bool zero, struct nvkm_memory **);
 	bool zero;
+	/* Objects are not nvkm_instobjs, and survive suspend untouched. */
+	bool persistent;
 };
 
 void nvkm_instmem_ctor(const struct nvkm_instmem_func *, struct nvkm_device *,
@@ -20,9 +38,12 @@ void nvkm_instmem_boot(struct nvkm_instmem *);
 
 #include <core/memory.h>
 
+#define nvkm_instobj(p) container_of((p), struct nvkm_instobj, memory)
+
 struct nvkm_instobj {
 	struct nvkm_memory memory;
 	struct list_head head;
+	enum nvkm_instobj_preserve preserve;
 	u32 *suspend;
 };
 
@@ -25,18 +25,64 @@
 
 #include <core/memory.h>
 
+static void
+nvkm_ltc_cbc_wait(struct nvkm_ltc *ltc)
+{
+	u64 time;
+
+	if (ltc->cbc.done == ltc->cbc.issued)
+		return;
+
+	time = ktime_to_ns(ktime_get());
+	ltc->func->cbc_wait(ltc);
+	time = ktime_to_ns(ktime_get()) - time;
+
+	ltc->cbc.waits++;
+	ltc->cbc.wait_ns += time;
+	ltc->cbc.wait_max_ns = max(ltc->cbc.wait_max_ns, time);
+	WRITE_ONCE(ltc->cbc.done, ltc->cbc.issued);
+}
+
 void
+nvkm_ltc_tags_wait(struct nvkm_device *device, u64 clear)
+{
+	struct nvkm_ltc *ltc = device->ltc;
+
+	if (READ_ONCE(ltc->cbc.done) >= clear)
+		return;
+
+	mutex_lock(&ltc->subdev.mutex);
+	if (ltc->cbc.done < clear)
+		nvkm_ltc_cbc_wait(ltc);
+	mutex_unlock(&ltc->subdev.mutex);
+}
+
+/* Kicks off a CBC clear without waiting for it to complete, the returned
+ * sequence number must be passed to nvkm_ltc_tags_wait() before the tags
+ * are used by the GPU.
+ *
+ * The CBC only takes a single range at a time, so a clear that's still
+ * outstanding is waited on before the next is issued.  The wait happens
+ * with the LTC mutex, and the FB mutex of nvkm_memory_tags_get(), held,
+ * meaning new comptag allocations are serialised behind the previous
+ * clear.  What overlaps the clear is the remainder of the map that
+ * requested it (its PTE writes, and the rest of a batched BIND).
+ */
+u64
 nvkm_ltc_tags_clear(struct nvkm_device *device, u32 first, u32 count)
 {
 	struct nvkm_ltc *ltc = device->ltc;
 	const u32 limit = first + count - 1;
+	u64 clear;
 
 	BUG_ON((first > limit) || (limit >= ltc->num_tags));
 
 	mutex_lock(&ltc->subdev.mutex);
+	nvkm_ltc_cbc_wait(ltc);
 	ltc->func->cbc_clear(ltc, first, limit);
-	ltc->func->cbc_wait(ltc);
+	clear = ++ltc->cbc.issued;
 	mutex_unlock(&ltc->subdev.mutex);
+	return clear;
 }
 
 int
@@ -98,10 +144,24 @@ nvkm_ltc_init(struct nvkm_subdev *subdev)
 	return 0;
 }
 
+static void
+nvkm_ltc_stat(struct nvkm_subdev *subdev, struct nvkm_subdev_stat *stat)
+{
+	struct nvkm_ltc *ltc = nvkm_ltc(subdev);
+	nvkm_stat(stat, "cbc clears", ltc->cbc.issued);
+	nvkm_stat(stat, "cbc waits", ltc->cbc.waits);
+	nvkm_stat(stat, "cbc wait ns", ltc->cbc.wait_ns);
+	nvkm_stat(stat, "cbc wait max ns", ltc->cbc.wait_max_ns);
+}
+
 static void *
 nvkm_ltc_dtor(struct nvkm_subdev *subdev)
 {
 	struct nvkm_ltc *ltc = nvkm_ltc(subdev);
+	nvkm_debug(subdev, "cbc: %lld clears, %lld waited, "
+			   "%lld ns total, %lld ns max\n",
+		   ltc->cbc.issued, ltc->cbc.waits,
+		   ltc->cbc.wait_ns, ltc->cbc.wait_max_ns);
 	nvkm_memory_unref(&ltc->tag_ram);
 	return ltc;
 }
@@ -112,6 +172,7 @@ nvkm_ltc = {
 	.oneinit = nvkm_ltc_oneinit,
 	.init = nvkm_ltc_init,
 	.intr = nvkm_ltc_intr,
+	.stat = nvkm_ltc_stat,
 };
 
 int
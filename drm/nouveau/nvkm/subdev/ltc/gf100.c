@@ -200,6 +200,10 @@ gf100_ltc_oneinit_tag_ram(struct nvkm_ltc *ltc)
 	}
 
 mm_init:
+	ret = nvkm_fb_tags_init(fb, ltc->num_tags);
+	if (ret)
+		return ret;
+
 	nvkm_mm_fini(&fb->tags);
 	return nvkm_mm_init(&fb->tags, 0, 0, ltc->num_tags, 1);
 }
@@ -109,39 +109,100 @@ nvkm_mmu_ptp_get(struct nvkm_mmu *mmu, u32 size, bool zero)
 	return pt;
 }
 
+/* Limits on the number of freed page tables cached for each size.
+ *
+ * Each size starts out with a small cache, which grows whenever a
+ * request can't be satisfied from it, up to a hard maximum and a cap
+ * on the total amount of memory held by all caches.
+ *
+ * Failure to allocate a new page table is taken as a sign of memory
+ * pressure, and will cause the caches to be emptied and shrunk.
+ */
+#define NVKM_MMU_PTC_LIMIT_MIN 8
+#define NVKM_MMU_PTC_LIMIT_MAX 256
+#define NVKM_MMU_PTC_BYTES_MAX (16 << 20)
+
 struct nvkm_mmu_ptc {
 	struct list_head head;
 	struct list_head item;
 	u32 size;
 	u32 refs;
+	u32 limit;
+
+	u64 hits;
+	u64 misses;
+	u64 evicts;
 };
 
 static inline struct nvkm_mmu_ptc *
 nvkm_mmu_ptc_find(struct nvkm_mmu *mmu, u32 size)
 {
-	struct nvkm_mmu_ptc *ptc;
+	const int order = order_base_2(size);
+	struct nvkm_mmu_ptc *ptc = mmu->ptc.find[order];
+
+	/* Page tables are almost always a power-of-two in size, so there
+	 * should only be a single cache for each order.
+	 */
+	if (ptc && ptc->size == size)
+		return ptc;
 
 	list_for_each_entry(ptc, &mmu->ptc.list, head) {
 		if (ptc->size == size)
-			return ptc;
+			goto done;
 	}
 
-	ptc = kmalloc(sizeof(*ptc), GFP_KERNEL);
+	ptc = kzalloc(sizeof(*ptc), GFP_KERNEL);
 	if (ptc) {
 		INIT_LIST_HEAD(&ptc->item);
 		ptc->size = size;
-		ptc->refs = 0;
+		ptc->limit = NVKM_MMU_PTC_LIMIT_MIN;
 		list_add(&ptc->head, &mmu->ptc.list);
 	}
 
+done:
+	mmu->ptc.find[order] = ptc;
 	return ptc;
 }
 
+static void
+nvkm_mmu_ptc_evict(struct nvkm_mmu *mmu, struct nvkm_mmu_ptc *ptc, u32 limit)
+{
+	struct nvkm_mmu_pt *pt, *tt;
+	list_for_each_entry_safe(pt, tt, &ptc->item, head) {
+		if (ptc->refs <= limit)
+			break;
+		nvkm_memory_unref(&pt->memory);
+		list_del(&pt->head);
+		kfree(pt);
+		mmu->ptc.bytes -= ptc->size;
+		ptc->refs--;
+		ptc->evicts++;
+	}
+}
+
+/* Release cached page tables in response to an allocation failure. */
+static bool
+nvkm_mmu_ptc_shrink(struct nvkm_mmu *mmu)
+{
+	struct nvkm_mmu_ptc *ptc;
+	bool freed = false;
+
+	list_for_each_entry(ptc, &mmu->ptc.list, head) {
+		freed |= ptc->refs != 0;
+		nvkm_mmu_ptc_evict(mmu, ptc, 0);
+		ptc->limit = NVKM_MMU_PTC_LIMIT_MIN;
+	}
+
+	return freed;
+}
+
 void
 nvkm_mmu_ptc_put(struct nvkm_mmu *mmu, bool force, struct nvkm_mmu_pt **ppt)
 {
 	struct nvkm_mmu_pt *pt = *ppt;
 	if (pt) {
+		struct nvkm_mmu_ptc *ptc;
+
 		/* Handle sub-allocated page tables. */
 		if (pt->sub) {
 			mutex_lock(&mmu->ptp.mutex);
@@ -152,10 +213,15 @@ nvkm_mmu_ptc_put(struct nvkm_mmu *mmu, bool force, struct nvkm_mmu_pt **ppt)
 
 		/* Either cache or free the object. */
 		mutex_lock(&mmu->ptc.mutex);
-		if (pt->ptc->refs < 8 /* Heuristic. */ && !force) {
-			list_add_tail(&pt->head, &pt->ptc->item);
-			pt->ptc->refs++;
+		ptc = pt->ptc;
+		if (!force && ptc->refs < ptc->limit &&
+		    mmu->ptc.bytes + ptc->size <= NVKM_MMU_PTC_BYTES_MAX) {
+			list_add_tail(&pt->head, &ptc->item);
+			mmu->ptc.bytes += ptc->size;
+			ptc->refs++;
 		} else {
+			if (!force)
+				ptc->evicts++;
 			nvkm_memory_unref(&pt->memory);
 			kfree(pt);
 		}
@@ -163,12 +229,48 @@ nvkm_mmu_ptc_put(struct nvkm_mmu *mmu, bool force, struct nvkm_mmu_pt **ppt)
 	}
 }
 
+static struct nvkm_mmu_pt *
+nvkm_mmu_ptc_new(struct nvkm_mmu *mmu, struct nvkm_mmu_ptc *ptc,
+		 u32 align, bool zero)
+{
+	struct nvkm_device *device = mmu->subdev.device;
+	struct nvkm_mmu_pt *pt;
+	int ret;
+
+	if (!(pt = kmalloc(sizeof(*pt), GFP_KERNEL)))
+		return NULL;
+	pt->ptc = ptc;
+	pt->sub = false;
+
+	ret = nvkm_memory_new(device, NVKM_MEM_TARGET_INST,
+			      ptc->size, align, zero, &pt->memory);
+	if (ret) {
+		/* Drop cached page tables to make room, and retry. */
+		mutex_lock(&mmu->ptc.mutex);
+		if (nvkm_mmu_ptc_shrink(mmu)) {
+			mutex_unlock(&mmu->ptc.mutex);
+			ret = nvkm_memory_new(device, NVKM_MEM_TARGET_INST,
+					      ptc->size, align, zero,
+					      &pt->memory);
+		} else {
+			mutex_unlock(&mmu->ptc.mutex);
+		}
+		if (ret) {
+			kfree(pt);
+			return NULL;
+		}
+	}
+
+	pt->base = 0;
+	pt->addr = nvkm_memory_addr(pt->memory);
+	return pt;
+}
+
 struct nvkm_mmu_pt *
 nvkm_mmu_ptc_get(struct nvkm_mmu *mmu, u32 size, u32 align, bool zero)
 {
 	struct nvkm_mmu_ptc *ptc;
 	struct nvkm_mmu_pt *pt;
-	int ret;
 
 	/* Sub-allocated page table (ie. GP100 LPT). */
 	if (align < 0x1000) {
@@ -192,42 +294,63 @@ nvkm_mmu_ptc_get(struct nvkm_mmu *mmu, u32 size, u32 align, bool zero)
 		if (zero)
 			nvkm_fo64(pt->memory, 0, 0, size >> 3);
 		list_del(&pt->head);
+		mmu->ptc.bytes -= size;
 		ptc->refs--;
+		ptc->hits++;
 		mutex_unlock(&mmu->ptc.mutex);
 		return pt;
 	}
+
+	/* No such luck, the cache wasn't large enough to satisfy demand,
+	 * allow it to hold more page tables in the future.
+	 */
+	if (ptc->limit < NVKM_MMU_PTC_LIMIT_MAX)
+		ptc->limit++;
+	ptc->misses++;
 	mutex_unlock(&mmu->ptc.mutex);
 
-	/* No such luck, we need to allocate. */
-	if (!(pt = kmalloc(sizeof(*pt), GFP_KERNEL)))
-		return NULL;
-	pt->ptc = ptc;
-	pt->sub = false;
+	/* We need to allocate. */
+	return nvkm_mmu_ptc_new(mmu, ptc, align, zero);
+}
 
-	ret = nvkm_memory_new(mmu->subdev.device, NVKM_MEM_TARGET_INST,
-			      size, align, zero, &pt->memory);
-	if (ret) {
-		kfree(pt);
-		return NULL;
+/* Pre-allocate page tables of a given size, so that a burst of activity
+ * in a newly-created VMM doesn't have to allocate them one at a time.
+ */
+void
+nvkm_mmu_ptc_prewarm(struct nvkm_mmu *mmu, u32 size, u32 align, u32 nr)
+{
+	struct nvkm_mmu_ptc *ptc;
+	struct nvkm_mmu_pt *pt;
+
+	if (!nr || align < 0x1000)
+		return;
+
+	mutex_lock(&mmu->ptc.mutex);
+	ptc = nvkm_mmu_ptc_find(mmu, size);
+	if (ptc) {
+		ptc->limit = clamp(nr, ptc->limit, (u32)NVKM_MMU_PTC_LIMIT_MAX);
+		nr = ptc->refs < nr ? nr - ptc->refs : 0;
 	}
+	mutex_unlock(&mmu->ptc.mutex);
+	if (!ptc)
+		return;
 
-	pt->base = 0;
-	pt->addr = nvkm_memory_addr(pt->memory);
-	return pt;
+	while (nr--) {
+		if (!(pt = nvkm_mmu_ptc_new(mmu, ptc, align, false)))
+			break;
+		nvkm_mmu_ptc_put(mmu, false, &pt);
+	}
 }
 
 void
 nvkm_mmu_ptc_dump(struct nvkm_mmu *mmu)
 {
 	struct nvkm_mmu_ptc *ptc;
+	mutex_lock(&mmu->ptc.mutex);
 	list_for_each_entry(ptc, &mmu->ptc.list, head) {
-		struct nvkm_mmu_pt *pt, *tt;
-		list_for_each_entry_safe(pt, tt, &ptc->item, head) {
-			nvkm_memory_unref(&pt->memory);
-			list_del(&pt->head);
-			kfree(pt);
-		}
+		nvkm_mmu_ptc_evict(mmu, ptc, 0);
 	}
+	mutex_unlock(&mmu->ptc.mutex);
 }
 
 static void
@@ -236,6 +359,10 @@ nvkm_mmu_ptc_fini(struct nvkm_mmu *mmu)
 	struct nvkm_mmu_ptc *ptc, *ptct;
 
 	list_for_each_entry_safe(ptc, ptct, &mmu->ptc.list, head) {
+		nvkm_debug(&mmu->subdev, "ptc %08x: limit %d, %lld hits, "
+					 "%lld misses, %lld evicts\n",
+			   ptc->size, ptc->limit, ptc->hits,
+			   ptc->misses, ptc->evicts);
 		WARN_ON(!list_empty(&ptc->item));
 		list_del(&ptc->head);
 		kfree(ptc);
@@ -401,6 +528,13 @@ nvkm_mmu_dtor(struct nvkm_subdev *subdev)
 
 	nvkm_vmm_unref(&mmu->vmm);
 
+	nvkm_debug(subdev, "host: %lld 2MiB, %lld 64KiB, %lld 4KiB chunks, "
+			   "%lld fallbacks\n",
+		   (s64)atomic64_read(&mmu->host.chunks[0]),
+		   (s64)atomic64_read(&mmu->host.chunks[1]),
+		   (s64)atomic64_read(&mmu->host.chunks[2]),
+		   (s64)atomic64_read(&mmu->host.fallback));
+
 	nvkm_mmu_ptc_fini(mmu);
 	return mmu;
 }
@@ -32,7 +32,8 @@ struct nvkm_mem {
 	enum nvkm_memory_target target;
 	struct nvkm_mmu *mmu;
 	u64 pages;
-	struct page **mem;
+	u8 page;
+	struct sg_table sgt; /* Host memory allocated by us, as extents. */
 	union {
 		struct scatterlist *sgl;
 		dma_addr_t *dma;
@@ -48,15 +49,15 @@ nvkm_mem_target(struct nvkm_memory *memory)
 static u8
 nvkm_mem_page(struct nvkm_memory *memory)
 {
-	return PAGE_SHIFT;
+	return nvkm_mem(memory)->page;
 }
 
 static u64
 nvkm_mem_addr(struct nvkm_memory *memory)
 {
 	struct nvkm_mem *mem = nvkm_mem(memory);
-	if (mem->pages == 1 && mem->mem)
-		return mem->dma[0];
+	if (mem->sgt.nents == 1)
+		return sg_dma_address(mem->sgt.sgl);
 	return ~0ULL;
 }
 
@@ -79,19 +80,35 @@ nvkm_mem_map_dma(struct nvkm_memory *memory, u64 offset, struct nvkm_vmm *vmm,
 	return nvkm_vmm_map(vmm, vma, argv, argc, &map);
 }
 
+static int
+nvkm_mem_map_dma_locked(struct nvkm_memory *memory, u64 offset,
+			struct nvkm_vmm *vmm, struct nvkm_vma *vma,
+			void *argv, u32 argc)
+{
+	struct nvkm_mem *mem = nvkm_mem(memory);
+	struct nvkm_vmm_map map = {
+		.memory = &mem->memory,
+		.offset = offset,
+		.dma = mem->dma,
+	};
+	return nvkm_vmm_map_locked(vmm, vma, argv, argc, &map);
+}
+
 static void *
 nvkm_mem_dtor(struct nvkm_memory *memory)
 {
 	struct nvkm_mem *mem = nvkm_mem(memory);
-	if (mem->mem) {
-		while (mem->pages--) {
-			dma_unmap_page(mem->mmu->subdev.device->dev,
-				       mem->dma[mem->pages], PAGE_SIZE,
+	if (mem->sgt.sgl) {
+		struct device *dev = mem->mmu->subdev.device->dev;
+		struct scatterlist *sgl;
+		int i;
+
+		for_each_sg(mem->sgt.sgl, sgl, mem->sgt.nents, i) {
+			dma_unmap_page(dev, sg_dma_address(sgl), sgl->length,
 				       DMA_BIDIRECTIONAL);
-			__free_page(mem->mem[mem->pages]);
+			__free_pages(sg_page(sgl), get_order(sgl->length));
 		}
-		kvfree(mem->dma);
-		kvfree(mem->mem);
+		sg_free_table(&mem->sgt);
 	}
 	return mem;
 }
@@ -104,6 +121,7 @@ nvkm_mem_dma = {
 	.addr = nvkm_mem_addr,
 	.size = nvkm_mem_size,
 	.map = nvkm_mem_map_dma,
+	.map_locked = nvkm_mem_map_dma_locked,
 };
 
 static int
@@ -119,6 +137,20 @@ nvkm_mem_map_sgl(struct nvkm_memory *memory, u64 offset, struct nvkm_vmm *vmm,
 	return nvkm_vmm_map(vmm, vma, argv, argc, &map);
 }
 
+static int
+nvkm_mem_map_sgl_locked(struct nvkm_memory *memory, u64 offset,
+			struct nvkm_vmm *vmm, struct nvkm_vma *vma,
+			void *argv, u32 argc)
+{
+	struct nvkm_mem *mem = nvkm_mem(memory);
+	struct nvkm_vmm_map map = {
+		.memory = &mem->memory,
+		.offset = offset,
+		.sgl = mem->sgl,
+	};
+	return nvkm_vmm_map_locked(vmm, vma, argv, argc, &map);
+}
+
 static const struct nvkm_memory_func
 nvkm_mem_sgl = {
 	.dtor = nvkm_mem_dtor,
@@ -127,24 +159,135 @@ nvkm_mem_sgl = {
 	.addr = nvkm_mem_addr,
 	.size = nvkm_mem_size,
 	.map = nvkm_mem_map_sgl,
+	.map_locked = nvkm_mem_map_sgl_locked,
 };
 
 int
 nvkm_mem_map_host(struct nvkm_memory *memory, void **pmap)
 {
 	struct nvkm_mem *mem = nvkm_mem(memory);
-	if (mem->mem) {
-		*pmap = vmap(mem->mem, mem->pages, VM_MAP, PAGE_KERNEL);
+	if (mem->sgt.sgl) {
+		struct scatterlist *sgl;
+		struct page **pages;
+		u64 nr = 0;
+		int i, j;
+
+		pages = kvmalloc(sizeof(*pages) * mem->pages, GFP_KERNEL);
+		if (!pages)
+			return -ENOMEM;
+
+		for_each_sg(mem->sgt.sgl, sgl, mem->sgt.nents, i) {
+			for (j = 0; j < sgl->length >> PAGE_SHIFT; j++)
+				pages[nr++] = nth_page(sg_page(sgl), j);
+		}
+
+		*pmap = vmap(pages, nr, VM_MAP, PAGE_KERNEL);
+		kvfree(pages);
 		return *pmap ? 0 : -EFAULT;
 	}
 	return -EINVAL;
 }
 
+/* Chunk sizes attempted for host allocations, largest first.  Anything
+ * above PAGE_SIZE is opportunistic, and once an order fails we don't try
+ * it again for the remainder of the allocation.
+ */
+static const u8
+nvkm_mem_host_shift[NVKM_MEM_HOST_ORDERS] = { 21, 16, PAGE_SHIFT };
+
+struct nvkm_mem_extent {
+	struct page *page;
+	dma_addr_t addr;
+	u8 shift;
+};
+
+static int
+nvkm_mem_new_host_extents(struct nvkm_mem *mem, u64 size, gfp_t gfp)
+{
+	struct nvkm_mmu *mmu = mem->mmu;
+	struct device *dev = mmu->subdev.device->dev;
+	struct nvkm_mem_extent *ext = NULL, *tmp;
+	struct scatterlist *sgl;
+	u32 nr = 0, max = 0;
+	int ret = -ENOMEM, i = 0, j;
+
+	while (size) {
+		const u8 shift = max_t(u8, nvkm_mem_host_shift[i], PAGE_SHIFT);
+		const unsigned int order = shift - PAGE_SHIFT;
+		const u64 bytes = 1ULL << shift;
+		struct page *p;
+		dma_addr_t addr;
+
+		if (order && bytes > size) {
+			i++;
+			continue;
+		}
+
+		if (nr == max) {
+			max = max ? max * 2 : 16;
+			if (!(tmp = kvmalloc(sizeof(*tmp) * max, GFP_KERNEL)))
+				goto done;
+			if (ext)
+				memcpy(tmp, ext, sizeof(*ext) * nr);
+			kvfree(ext);
+			ext = tmp;
+		}
+
+		if (order)
+			p = alloc_pages(gfp | __GFP_NORETRY | __GFP_NOWARN, order);
+		else
+			p = alloc_pages(gfp, 0);
+
+		if (p) {
+			addr = dma_map_page(dev, p, 0, bytes, DMA_BIDIRECTIONAL);
+			if (dma_mapping_error(dev, addr)) {
+				__free_pages(p, order);
+				p = NULL;
+			}
+		}
+
+		if (!p) {
+			if (!order)
+				goto done;
+			atomic64_inc(&mmu->host.fallback);
+			i++;
+			continue;
+		}
+
+		ext[nr].page = p;
+		ext[nr].addr = addr;
+		ext[nr].shift = shift;
+		nr++;
+
+		atomic64_inc(&mmu->host.chunks[i]);
+		size -= bytes;
+	}
+
+	if ((ret = sg_alloc_table(&mem->sgt, nr, GFP_KERNEL)))
+		goto done;
+
+	for_each_sg(mem->sgt.sgl, sgl, nr, j) {
+		sg_set_page(sgl, ext[j].page, 1ULL << ext[j].shift, 0);
+		sg_dma_address(sgl) = ext[j].addr;
+		sg_dma_len(sgl) = 1ULL << ext[j].shift;
+	}
+
+	mem->sgl = mem->sgt.sgl;
+	nr = 0;
+done:
+	while (nr--) {
+		dma_unmap_page(dev, ext[nr].addr, 1ULL << ext[nr].shift,
+			       DMA_BIDIRECTIONAL);
+		__free_pages(ext[nr].page, ext[nr].shift - PAGE_SHIFT);
+	}
+	kvfree(ext);
+	return ret;
+}
+
 static int
 nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 		  void *argv, u32 argc, struct nvkm_memory **pmemory)
 {
-	struct device *dev = mmu->subdev.device->dev;
 	union {
 		struct nvif_mem_ram_vn vn;
 		struct nvif_mem_ram_v0 v0;
@@ -167,6 +310,7 @@ nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 		return -ENOMEM;
 	mem->target = target;
 	mem->mmu = mmu;
+	mem->page = PAGE_SHIFT;
 	*pmemory = &mem->memory;
 
 	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, false))) {
@@ -188,36 +332,16 @@ nvkm_mem_new_host(struct nvkm_mmu *mmu, int type, u8 page, u64 size,
 		return ret;
 	}
 
-	nvkm_memory_ctor(&nvkm_mem_dma, &mem->memory);
-	size = ALIGN(size, PAGE_SIZE) >> PAGE_SHIFT;
-
-	if (!(mem->mem = kvmalloc(sizeof(*mem->mem) * size, GFP_KERNEL)))
-		return -ENOMEM;
-	if (!(mem->dma = kvmalloc(sizeof(*mem->dma) * size, GFP_KERNEL)))
-		return -ENOMEM;
+	nvkm_memory_ctor(&nvkm_mem_sgl, &mem->memory);
+	size = ALIGN(size, PAGE_SIZE);
+	mem->pages = size >> PAGE_SHIFT;
 
 	if (mmu->dma_bits > 32)
 		gfp |= GFP_HIGHUSER;
 	else
 		gfp |= GFP_DMA32;
 
-	for (mem->pages = 0; size; size--, mem->pages++) {
-		struct page *p = alloc_page(gfp);
-		if (!p)
-			return -ENOMEM;
-
-		mem->dma[mem->pages] = dma_map_page(mmu->subdev.device->dev,
-						    p, 0, PAGE_SIZE,
-						    DMA_BIDIRECTIONAL);
-		if (dma_mapping_error(dev, mem->dma[mem->pages])) {
-			__free_page(p);
-			return -ENOMEM;
-		}
-
-		mem->mem[mem->pages] = p;
-	}
-
-	return 0;
+	return nvkm_mem_new_host_extents(mem, size, gfp);
 }
 
 int
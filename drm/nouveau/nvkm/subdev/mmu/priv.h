@@ -62,4 +62,5 @@ void nvkm_mmu_ptc_dump(struct nvkm_mmu *);
 struct nvkm_mmu_pt *
 nvkm_mmu_ptc_get(struct nvkm_mmu *, u32 size, u32 align, bool zero);
 void nvkm_mmu_ptc_put(struct nvkm_mmu *, bool force, struct nvkm_mmu_pt **);
+void nvkm_mmu_ptc_prewarm(struct nvkm_mmu *, u32 size, u32 align, u32 nr);
 #endif
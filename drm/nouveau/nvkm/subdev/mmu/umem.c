@@ -121,13 +121,29 @@ nvkm_umem_map(struct nvkm_object *object, void *argv, u32 argc,
 	return 0;
 }
 
+static enum nvkm_client_mem
+nvkm_umem_charge_type(struct nvkm_umem *umem)
+{
+	if (umem->type & NVKM_MEM_VRAM)
+		return NVKM_CLIENT_MEM_VRAM;
+	return NVKM_CLIENT_MEM_HOST;
+}
+
 static void *
 nvkm_umem_dtor(struct nvkm_object *object)
 {
 	struct nvkm_umem *umem = nvkm_umem(object);
-	spin_lock(&umem->object.client->lock);
+	struct nvkm_client *client = umem->object.client;
+
+	/* Only objects that made it onto the client's list were charged. */
+	if (!list_empty(&umem->head)) {
+		nvkm_client_charge(client, nvkm_umem_charge_type(umem),
+				   -nvkm_memory_size(umem->memory));
+	}
+
+	spin_lock(&client->lock);
 	list_del_init(&umem->head);
-	spin_unlock(&umem->object.client->lock);
+	spin_unlock(&client->lock);
 	nvkm_memory_unref(&umem->memory);
 	return umem;
 }
@@ -185,6 +201,9 @@ nvkm_umem_new(const struct nvkm_oclass *oclass, void *argv, u32 argc,
 	list_add(&umem->head, &umem->object.client->umem);
 	spin_unlock(&umem->object.client->lock);
 
+	nvkm_client_charge(umem->object.client, nvkm_umem_charge_type(umem),
+			   nvkm_memory_size(umem->memory));
+
 	args->v0.page = nvkm_memory_page(umem->memory);
 	args->v0.addr = nvkm_memory_addr(umem->memory);
 	args->v0.size = nvkm_memory_size(umem->memory);
@@ -43,101 +43,95 @@ nvkm_uvmm_search(struct nvkm_client *client, u64 handle)
 }
 
 static int
-nvkm_uvmm_mthd_unmap(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+nvkm_uvmm_unmap_locked(struct nvkm_uvmm *uvmm, u64 addr)
 {
 	struct nvkm_client *client = uvmm->object.client;
-	union {
-		struct nvif_vmm_unmap_v0 v0;
-	} *args = argv;
 	struct nvkm_vmm *vmm = uvmm->vmm;
 	struct nvkm_vma *vma;
-	int ret = -ENOSYS;
-	u64 addr;
 
-	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, false))) {
-		addr = args->v0.addr;
-	} else
-		return ret;
-
-	mutex_lock(&vmm->mutex);
 	vma = nvkm_vmm_node_search(vmm, addr);
-	if (ret = -ENOENT, !vma || vma->addr != addr) {
+	if (!vma || vma->addr != addr) {
 		VMM_DEBUG(vmm, "lookup %016llx: %016llx",
 			  addr, vma ? vma->addr : ~0ULL);
-		goto done;
+		return -ENOENT;
 	}
 
-	if (ret = -ENOENT, (!vma->user && !client->super) || vma->busy) {
+	if ((!vma->user && !client->super) || vma->busy) {
 		VMM_DEBUG(vmm, "denied %016llx: %d %d %d", addr,
 			  vma->user, !client->super, vma->busy);
-		goto done;
+		return -ENOENT;
 	}
 
-	if (ret = -EINVAL, !vma->memory) {
+	if (!vma->memory) {
 		VMM_DEBUG(vmm, "unmapped");
-		goto done;
+		return -EINVAL;
 	}
 
 	nvkm_vmm_unmap_locked(vmm, vma);
-	ret = 0;
-done:
-	mutex_unlock(&vmm->mutex);
-	return ret;
+	return 0;
 }
 
 static int
-nvkm_uvmm_mthd_map(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+nvkm_uvmm_mthd_unmap(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 {
-	struct nvkm_client *client = uvmm->object.client;
 	union {
-		struct nvif_vmm_map_v0 v0;
+		struct nvif_vmm_unmap_v0 v0;
 	} *args = argv;
-	u64 addr, size, handle, offset;
 	struct nvkm_vmm *vmm = uvmm->vmm;
-	struct nvkm_vma *vma;
-	struct nvkm_memory *memory;
 	int ret = -ENOSYS;
+	u64 addr;
 
-	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, true))) {
+	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, false))) {
 		addr = args->v0.addr;
-		size = args->v0.size;
-		handle = args->v0.memory;
-		offset = args->v0.offset;
 	} else
 		return ret;
 
-	memory = nvkm_umem_search(client, handle);
-	if (IS_ERR(memory)) {
-		VMM_DEBUG(vmm, "memory %016llx %ld\n", handle, PTR_ERR(memory));
-		return PTR_ERR(memory);
-	}
-
 	mutex_lock(&vmm->mutex);
-	if (ret = -ENOENT, !(vma = nvkm_vmm_node_search(vmm, addr))) {
+	ret = nvkm_uvmm_unmap_locked(uvmm, addr);
+	mutex_unlock(&vmm->mutex);
+	return ret;
+}
+
+/* Locate the VMA covering a user-requested mapping, splitting it off from
+ * the surrounding allocation if necessary, and mark it busy.
+ */
+static int
+nvkm_uvmm_map_region(struct nvkm_uvmm *uvmm, u64 addr, u64 size,
+		     struct nvkm_vma **pvma)
+{
+	struct nvkm_client *client = uvmm->object.client;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvkm_vma *vma;
+
+	if (!(vma = nvkm_vmm_node_search(vmm, addr))) {
 		VMM_DEBUG(vmm, "lookup %016llx", addr);
-		goto fail;
+		return -ENOENT;
 	}
 
-	if (ret = -ENOENT, (!vma->user && !client->super) || vma->busy) {
+	if ((!vma->user && !client->super) || vma->busy) {
 		VMM_DEBUG(vmm, "denied %016llx: %d %d %d", addr,
 			  vma->user, !client->super, vma->busy);
-		goto fail;
+		return -ENOENT;
 	}
 
-	if (ret = -EINVAL, vma->addr != addr || vma->size != size) {
+	if (vma->addr != addr || vma->size != size) {
 		if (addr + size > vma->addr + vma->size || vma->memory ||
 		    (vma->refd == NVKM_VMA_PAGE_NONE && !vma->mapref)) {
 			VMM_DEBUG(vmm, "split %d %d %d "
 				       "%016llx %016llx %016llx %016llx",
 				  !!vma->memory, vma->refd, vma->mapref,
 				  addr, size, vma->addr, (u64)vma->size);
-			goto fail;
+			return -EINVAL;
 		}
 
+		/* Lockless lookups must not see the region partially split. */
+		nvkm_vmm_node_write_begin(vmm);
 		if (vma->addr != addr) {
 			const u64 tail = vma->size + vma->addr - addr;
-			if (ret = -ENOMEM, !(vma = nvkm_vma_tail(vma, tail)))
-				goto fail;
+			if (!(vma = nvkm_vma_tail(vma, tail))) {
+				nvkm_vmm_node_write_end(vmm);
+				return -ENOMEM;
+			}
 			vma->part = true;
 			nvkm_vmm_node_insert(vmm, vma);
 		}
@@ -145,33 +139,167 @@ nvkm_uvmm_mthd_map(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 		if (vma->size != size) {
 			const u64 tail = vma->size - size;
 			struct nvkm_vma *tmp;
-			if (ret = -ENOMEM, !(tmp = nvkm_vma_tail(vma, tail))) {
+			if (!(tmp = nvkm_vma_tail(vma, tail))) {
 				nvkm_vmm_unmap_region(vmm, vma);
-				goto fail;
+				nvkm_vmm_node_write_end(vmm);
+				return -ENOMEM;
 			}
 			tmp->part = true;
 			nvkm_vmm_node_insert(vmm, tmp);
 		}
+		nvkm_vmm_node_write_end(vmm);
 	}
+
 	vma->busy = true;
+	*pvma = vma;
+	return 0;
+}
+
+static int
+nvkm_uvmm_mthd_map(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+{
+	struct nvkm_client *client = uvmm->object.client;
+	union {
+		struct nvif_vmm_map_v0 v0;
+	} *args = argv;
+	u64 addr, size, handle, offset;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvkm_vma *vma;
+	struct nvkm_memory *memory;
+	int ret = -ENOSYS;
+
+	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, true))) {
+		addr = args->v0.addr;
+		size = args->v0.size;
+		handle = args->v0.memory;
+		offset = args->v0.offset;
+	} else
+		return ret;
+
+	memory = nvkm_umem_search(client, handle);
+	if (IS_ERR(memory)) {
+		VMM_DEBUG(vmm, "memory %016llx %ld\n", handle, PTR_ERR(memory));
+		return PTR_ERR(memory);
+	}
+
+	mutex_lock(&vmm->mutex);
+	ret = nvkm_uvmm_map_region(uvmm, addr, size, &vma);
 	mutex_unlock(&vmm->mutex);
+	if (ret)
+		goto done;
 
 	ret = nvkm_memory_map(memory, offset, vmm, vma, argv, argc);
 	if (ret == 0) {
 		/* Successful map will clear vma->busy. */
-		nvkm_memory_unref(&memory);
-		return 0;
+		goto done;
 	}
 
 	mutex_lock(&vmm->mutex);
 	vma->busy = false;
 	nvkm_vmm_unmap_region(vmm, vma);
-fail:
 	mutex_unlock(&vmm->mutex);
+done:
 	nvkm_memory_unref(&memory);
 	return ret;
 }
 
+static int
+nvkm_uvmm_bind_map(struct nvkm_uvmm *uvmm, struct nvif_vmm_bind_op_v0 *op)
+{
+	struct nvkm_client *client = uvmm->object.client;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvkm_memory *memory;
+	struct nvkm_vma *vma;
+	int ret;
+
+	memory = nvkm_umem_search(client, op->memory);
+	if (IS_ERR(memory)) {
+		VMM_DEBUG(vmm, "memory %016llx %ld\n",
+			  op->memory, PTR_ERR(memory));
+		return PTR_ERR(memory);
+	}
+
+	if (!memory->func->map_locked) {
+		VMM_DEBUG(vmm, "memory %016llx can't be bound", op->memory);
+		ret = -EINVAL;
+		goto done;
+	}
+
+	ret = nvkm_uvmm_map_region(uvmm, op->addr, op->size, &vma);
+	if (ret == 0) {
+		ret = nvkm_memory_map_locked(memory, op->offset, vmm, vma,
+					     op->data, op->argc);
+		vma->busy = false;
+		if (ret)
+			nvkm_vmm_unmap_region(vmm, vma);
+	}
+
+done:
+	nvkm_memory_unref(&memory);
+	return ret;
+}
+
+static int
+nvkm_uvmm_mthd_bind(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+{
+	union {
+		struct nvif_vmm_bind_v0 v0;
+	} *args = argv;
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	struct nvif_vmm_bind_op_v0 *op;
+	int ret = -ENOSYS;
+	u8 *data;
+	u32 size, count, i;
+
+	if (!(ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, true))) {
+		count = args->v0.count;
+	} else
+		return ret;
+
+	/* Validate the layout of the entire list before touching anything. */
+	for (data = argv, size = argc, i = 0; i < count; i++) {
+		u32 len;
+		if (size < sizeof(*op))
+			return -EINVAL;
+		op = (void *)data;
+		len = sizeof(*op) + ALIGN(op->argc, 8);
+		if (size < len)
+			return -EINVAL;
+		data += len;
+		size -= len;
+	}
+
+	if (size)
+		return -EINVAL;
+
+	/* Process each entry under a single hold of the VMM lock, with TLB
+	 * invalidation deferred until the entire list has been processed.
+	 *
+	 * Memory unmapped or replaced by an entry stays referenced until the
+	 * final nvkm_vmm_flush_commit() has invalidated the TLBs.
+	 */
+	mutex_lock(&vmm->mutex);
+	nvkm_vmm_flush_begin(vmm);
+	for (data = argv, i = 0; i < count; i++) {
+		op = (void *)data;
+		switch (op->op) {
+		case NVIF_VMM_BIND_OP_V0_MAP:
+			op->result = nvkm_uvmm_bind_map(uvmm, op);
+			break;
+		case NVIF_VMM_BIND_OP_V0_UNMAP:
+			op->result = nvkm_uvmm_unmap_locked(uvmm, op->addr);
+			break;
+		default:
+			op->result = -EINVAL;
+			break;
+		}
+		data += sizeof(*op) + ALIGN(op->argc, 8);
+	}
+	nvkm_vmm_flush_commit(vmm);
+	mutex_unlock(&vmm->mutex);
+	return 0;
+}
+
 static int
 nvkm_uvmm_mthd_put(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 {
@@ -274,26 +402,132 @@ nvkm_uvmm_mthd_page(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
 	return 0;
 }
 
+static int
+nvkm_uvmm_mthd_footprint(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+{
+	union {
+		struct nvif_vmm_footprint_v0 v0;
+	} *args = argv;
+	struct nvkm_vmm_footprint fp;
+	int ret = -ENOSYS, i;
+
+	if ((ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, false)))
+		return ret;
+
+	nvkm_vmm_footprint(uvmm->vmm, &fp);
+
+	args->v0.level_nr = min_t(int, fp.level_nr, ARRAY_SIZE(args->v0.level));
+	for (i = 0; i < args->v0.level_nr; i++) {
+		struct nvif_vmm_footprint_level_v0 *level = &args->v0.level[i];
+		switch (fp.level[i].desc->type) {
+		case PGD: level->type = NVIF_VMM_FOOTPRINT_LEVEL_V0_PGD; break;
+		case PGT: level->type = NVIF_VMM_FOOTPRINT_LEVEL_V0_PGT; break;
+		case SPT: level->type = NVIF_VMM_FOOTPRINT_LEVEL_V0_SPT; break;
+		case LPT: level->type = NVIF_VMM_FOOTPRINT_LEVEL_V0_LPT; break;
+		default:
+			WARN_ON(1);
+			break;
+		}
+		level->bits = fp.level[i].desc->bits;
+		level->tables = fp.level[i].tables;
+		level->hwpts = fp.level[i].hwpts;
+		level->sparse = fp.level[i].sparse;
+		level->refs = fp.level[i].refs;
+		level->bytes = fp.level[i].bytes;
+		level->swbytes = fp.level[i].swbytes;
+	}
+
+	args->v0.page_nr = min_t(int, fp.page_nr, ARRAY_SIZE(args->v0.page));
+	for (i = 0; i < args->v0.page_nr; i++) {
+		args->v0.page[i].shift = uvmm->vmm->func->page[i].shift;
+		args->v0.page[i].mapped = fp.page[i];
+	}
+
+	args->v0.mapped_addr = fp.mapped_addr;
+	args->v0.mapped_size = fp.mapped_size;
+	args->v0.unmapped_addr = fp.unmapped_addr;
+	args->v0.unmapped_size = fp.unmapped_size;
+	return 0;
+}
+
+static void
+nvkm_uvmm_charge(struct nvkm_uvmm *uvmm)
+{
+	struct nvkm_vmm *vmm = uvmm->vmm;
+	s64 bytes;
+
+	/* The shared pre-NV50 VMM isn't owned by any one client. */
+	if (vmm == vmm->mmu->vmm)
+		return;
+
+	mutex_lock(&vmm->mutex);
+	bytes = vmm->pt_bytes - uvmm->pt_bytes;
+	uvmm->pt_bytes = vmm->pt_bytes;
+	mutex_unlock(&vmm->mutex);
+
+	if (bytes)
+		nvkm_client_charge(uvmm->object.client, NVKM_CLIENT_MEM_PGT, bytes);
+}
+
+static int
+nvkm_uvmm_mthd_lookup(struct nvkm_uvmm *uvmm, void *argv, u32 argc)
+{
+	union {
+		struct nvif_vmm_lookup_v0 v0;
+	} *args = argv;
+	struct nvkm_vma_info info;
+	int ret = -ENOSYS;
+
+	if ((ret = nvif_unpack(ret, &argv, &argc, args->v0, 0, 0, false)))
+		return ret;
+
+	/* Uses the lockless path, it doesn't wait for vmm->mutex. */
+	ret = nvkm_vmm_node_lookup(uvmm->vmm, args->v0.addr, &info);
+	if (ret)
+		return ret;
+
+	args->v0.mapped = info.mapped;
+	args->v0.sparse = info.sparse;
+	args->v0.user = info.user;
+	args->v0.addr = info.addr;
+	args->v0.size = info.size;
+	return 0;
+}
+
 static int
 nvkm_uvmm_mthd(struct nvkm_object *object, u32 mthd, void *argv, u32 argc)
 {
 	struct nvkm_uvmm *uvmm = nvkm_uvmm(object);
+	int ret;
+
 	switch (mthd) {
 	case NVIF_VMM_V0_PAGE  : return nvkm_uvmm_mthd_page  (uvmm, argv, argc);
-	case NVIF_VMM_V0_GET   : return nvkm_uvmm_mthd_get   (uvmm, argv, argc);
-	case NVIF_VMM_V0_PUT   : return nvkm_uvmm_mthd_put   (uvmm, argv, argc);
-	case NVIF_VMM_V0_MAP   : return nvkm_uvmm_mthd_map   (uvmm, argv, argc);
-	case NVIF_VMM_V0_UNMAP : return nvkm_uvmm_mthd_unmap (uvmm, argv, argc);
+	case NVIF_VMM_V0_GET   : ret = nvkm_uvmm_mthd_get   (uvmm, argv, argc); break;
+	case NVIF_VMM_V0_PUT   : ret = nvkm_uvmm_mthd_put   (uvmm, argv, argc); break;
+	case NVIF_VMM_V0_MAP   : ret = nvkm_uvmm_mthd_map   (uvmm, argv, argc); break;
+	case NVIF_VMM_V0_UNMAP : ret = nvkm_uvmm_mthd_unmap (uvmm, argv, argc); break;
+	case NVIF_VMM_V0_BIND  : ret = nvkm_uvmm_mthd_bind  (uvmm, argv, argc); break;
+	case NVIF_VMM_V0_FOOTPRINT:
+		return nvkm_uvmm_mthd_footprint(uvmm, argv, argc);
+	case NVIF_VMM_V0_LOOKUP:
+		return nvkm_uvmm_mthd_lookup(uvmm, argv, argc);
 	default:
-		break;
+		return -EINVAL;
 	}
-	return -EINVAL;
+
+	/* Page tables may have been allocated or freed. */
+	nvkm_uvmm_charge(uvmm);
+	return ret;
 }
 
 static void *
 nvkm_uvmm_dtor(struct nvkm_object *object)
 {
 	struct nvkm_uvmm *uvmm = nvkm_uvmm(object);
+	if (uvmm->vmm) {
+		nvkm_client_charge(uvmm->object.client, NVKM_CLIENT_MEM_PGT,
+				   -uvmm->pt_bytes);
+	}
 	nvkm_vmm_unref(&uvmm->vmm);
 	return uvmm;
 }
@@ -336,6 +570,7 @@ nvkm_uvmm_new(const struct nvkm_oclass *oclass, void *argv, u32 argc,
 			return ret;
 
 		uvmm->vmm->debug = max(uvmm->vmm->debug, oclass->client->debug);
+		nvkm_uvmm_charge(uvmm);
 	} else {
 		if (size)
 			return -EINVAL;
@@ -7,6 +7,7 @@
 struct nvkm_uvmm {
 	struct nvkm_object object;
 	struct nvkm_vmm *vmm;
+	u64 pt_bytes; /* Page-table memory charged to the client. */
 };
 
 int nvkm_uvmm_new(const struct nvkm_oclass *, void *argv, u32 argc,
@@ -19,10 +19,11 @@
  * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
  * OTHER DEALINGS IN THE SOFTWARE.
  */
-#define NVKM_VMM_LEVELS_MAX 5
 #include "vmm.h"
 
+#include <core/option.h>
 #include <subdev/fb.h>
+#include <subdev/ltc.h>
 
 static void
 nvkm_vmm_pt_del(struct nvkm_vmm_pt **ppgt)
@@ -125,15 +126,131 @@ nvkm_vmm_flush_mark(struct nvkm_vmm_iter *it)
 static inline void
 nvkm_vmm_flush(struct nvkm_vmm_iter *it)
 {
+	struct nvkm_vmm *vmm = it->vmm;
 	if (it->flush != NVKM_VMM_LEVELS_MAX) {
-		if (it->vmm->func->flush) {
+		if (vmm->func->flush) {
+			/* Cover anything pending from a flush transaction. */
+			if (vmm->flush.depth != NVKM_VMM_LEVELS_MAX) {
+				it->flush = min(it->flush, vmm->flush.depth);
+				vmm->flush.depth = NVKM_VMM_LEVELS_MAX;
+				vmm->flush.avoided++;
+			}
 			TRA(it, "flush: %d", it->flush);
-			it->vmm->func->flush(it->vmm, it->flush);
+			vmm->func->flush(vmm, it->flush);
+			vmm->flush.issued++;
 		}
 		it->flush = NVKM_VMM_LEVELS_MAX;
 	}
 }
 
+/* Flush at the end of a PTE operation.  Inside a flush transaction, only
+ * the highest level requiring invalidation is recorded, and the MMU is
+ * flushed once when the outermost transaction is committed.
+ *
+ * Flushes required before page tables are freed are never deferred.
+ */
+static inline void
+nvkm_vmm_flush_done(struct nvkm_vmm_iter *it)
+{
+	struct nvkm_vmm *vmm = it->vmm;
+	if (vmm->flush.defer && vmm->func->flush &&
+	    it->flush != NVKM_VMM_LEVELS_MAX) {
+		if (vmm->flush.depth != NVKM_VMM_LEVELS_MAX)
+			vmm->flush.avoided++;
+		vmm->flush.depth = min(vmm->flush.depth, it->flush);
+		it->flush = NVKM_VMM_LEVELS_MAX;
+		return;
+	}
+	nvkm_vmm_flush(it);
+}
+
+static void
+nvkm_vmm_flush_tags(struct nvkm_vmm *vmm)
+{
+	/* Comptags cleared for new mappings must be ready before the
+	 * mappings are handed back, as work may be submitted that uses
+	 * them immediately after.
+	 */
+	if (vmm->flush.tags) {
+		nvkm_ltc_tags_wait(vmm->mmu->subdev.device, vmm->flush.tags);
+		vmm->flush.tags = 0;
+	}
+}
+
+static void
+nvkm_vmm_flush_pending(struct nvkm_vmm *vmm)
+{
+	if (vmm->flush.depth != NVKM_VMM_LEVELS_MAX) {
+		VMM_TRACE(vmm, "flush: %d", vmm->flush.depth);
+		vmm->func->flush(vmm, vmm->flush.depth);
+		vmm->flush.depth = NVKM_VMM_LEVELS_MAX;
+		vmm->flush.issued++;
+	}
+}
+
+/* Memory (and its comptags) that's been unmapped while an invalidate is
+ * still pending can remain in the GPU's TLBs, and must not be released
+ * until the flush transaction has been committed.
+ */
+struct nvkm_vmm_release {
+	struct list_head head;
+	struct nvkm_memory *memory;
+	struct nvkm_tags *tags;
+};
+
+static void
+nvkm_vmm_release(struct nvkm_vmm *vmm, struct nvkm_memory **pmemory,
+		 struct nvkm_tags **ptags)
+{
+	struct nvkm_device *device = vmm->mmu->subdev.device;
+	struct nvkm_vmm_release *release;
+
+	if (*pmemory && vmm->flush.depth != NVKM_VMM_LEVELS_MAX) {
+		release = kmalloc(sizeof(*release), GFP_KERNEL);
+		if (release) {
+			release->memory = *pmemory;
+			release->tags = *ptags;
+			list_add_tail(&release->head, &vmm->flush.release);
+			*pmemory = NULL;
+			*ptags = NULL;
+			return;
+		}
+
+		/* No memory to track it, invalidate now instead. */
+		nvkm_vmm_flush_pending(vmm);
+	}
+
+	nvkm_memory_tags_put(*pmemory, device, ptags);
+	nvkm_memory_unref(pmemory);
+}
+
+void
+nvkm_vmm_flush_begin(struct nvkm_vmm *vmm)
+{
+	vmm->flush.defer++;
+}
+
+void
+nvkm_vmm_flush_commit(struct nvkm_vmm *vmm)
+{
+	struct nvkm_device *device = vmm->mmu->subdev.device;
+	struct nvkm_vmm_release *release, *temp;
+
+	if (WARN_ON(!vmm->flush.defer) || --vmm->flush.defer)
+		return;
+
+	nvkm_vmm_flush_pending(vmm);
+
+	list_for_each_entry_safe(release, temp, &vmm->flush.release, head) {
+		nvkm_memory_tags_put(release->memory, device, &release->tags);
+		nvkm_memory_unref(&release->memory);
+		list_del(&release->head);
+		kfree(release);
+	}
+
+	nvkm_vmm_flush_tags(vmm);
+}
+
 static void
 nvkm_vmm_unref_pdes(struct nvkm_vmm_iter *it)
 {
@@ -144,6 +261,7 @@ nvkm_vmm_unref_pdes(struct nvkm_vmm_iter *it)
 	struct nvkm_mmu_pt *pt = pgt->pt[type];
 	struct nvkm_vmm *vmm = it->vmm;
 	u32 pdei = it->pte[it->lvl + 1];
+	u32 size = desc[it->lvl].size * (1 << desc[it->lvl].bits);
 
 	/* Recurse up the tree, unreferencing/destroying unneeded PDs. */
 	it->lvl++;
@@ -187,6 +305,8 @@ nvkm_vmm_unref_pdes(struct nvkm_vmm_iter *it)
 
 	/* Destroy PD/PT. */
 	TRA(it, "PDE free %s", nvkm_vmm_desc_type(&desc[it->lvl - 1]));
+	if (pt)
+		vmm->pt_bytes -= size;
 	nvkm_mmu_ptc_put(vmm->mmu, vmm->bootstrapped, &pt);
 	if (!pgt->refs[!type])
 		nvkm_vmm_pt_del(&pgt);
@@ -419,6 +539,7 @@ nvkm_vmm_ref_hwpt(struct nvkm_vmm_iter *it, struct nvkm_vmm_pt *pgd, u32 pdei)
 		nvkm_vmm_unref_pdes(it);
 		return false;
 	}
+	vmm->pt_bytes += size;
 
 	if (zero)
 		goto done;
@@ -570,7 +691,7 @@ nvkm_vmm_iter(struct nvkm_vmm *vmm, const struct nvkm_vmm_page *page,
 		}
 	};
 
-	nvkm_vmm_flush(&it);
+	nvkm_vmm_flush_done(&it);
 	return ~0ULL;
 
 fail:
@@ -614,6 +735,12 @@ nvkm_vmm_ptes_sparse_get(struct nvkm_vmm *vmm, const struct nvkm_vmm_page *page,
 	return -EINVAL;
 }
 
+/* Mark (or unmark) a region sparse using the largest page sizes its size
+ * and alignment allow.  On GM200/GP100 the largest of these are PD-level
+ * "pages", so a large reservation only writes a handful of PDEs, and the
+ * PTs below them are only allocated (from the SPARSED PDE state) once
+ * memory is actually mapped there.
+ */
 static int
 nvkm_vmm_ptes_sparse(struct nvkm_vmm *vmm, u64 addr, u64 size, bool ref)
 {
@@ -731,6 +858,68 @@ nvkm_vmm_ptes_get(struct nvkm_vmm *vmm, const struct nvkm_vmm_page *page,
 	return 0;
 }
 
+/* PTEs are staged in a local buffer, and written to the page table with
+ * bulk copies, rather than going through the memory accessors one word
+ * at a time.  The buffer holds PTEs as pairs of 32-bit words, matching
+ * the layout produced by nvkm_wo64() regardless of host endianness.
+ */
+#define NVKM_VMM_PTE_RUN 32
+
+static inline void
+nvkm_vmm_pte_copy(struct nvkm_mmu_pt *pt, u32 ptei, const u32 *data, u32 ptes)
+{
+	nvkm_memory_copy_to(pt->memory, pt->base + ptei * 8, data, ptes * 8);
+}
+
+void
+nvkm_vmm_pte_run64(struct nvkm_vmm *vmm, struct nvkm_mmu_pt *pt,
+		   u32 ptei, u32 ptes, u64 data, u64 next)
+{
+	u32 buf[NVKM_VMM_PTE_RUN * 2];
+
+	VMM_SPAM(vmm, "   %010llx %016llx %08x +%016llx",
+		 pt->addr + ptei * 8, data, ptes, next);
+
+	while (ptes) {
+		const u32 nr = min_t(u32, ptes, NVKM_VMM_PTE_RUN);
+		u32 i;
+
+		for (i = 0; i < nr; i++, data += next) {
+			buf[i * 2 + 0] = lower_32_bits(data);
+			buf[i * 2 + 1] = upper_32_bits(data);
+		}
+
+		nvkm_vmm_pte_copy(pt, ptei, buf, nr);
+		ptei += nr;
+		ptes -= nr;
+	}
+}
+
+void
+nvkm_vmm_pte_dma64(struct nvkm_vmm *vmm, struct nvkm_mmu_pt *pt,
+		   u32 ptei, u32 ptes, struct nvkm_vmm_map *map, int shift)
+{
+	u32 buf[NVKM_VMM_PTE_RUN * 2];
+
+	while (ptes) {
+		const u32 nr = min_t(u32, ptes, NVKM_VMM_PTE_RUN);
+		u32 i;
+
+		for (i = 0; i < nr; i++) {
+			const u64 data = (*map->dma++ >> shift) | map->type;
+			VMM_SPAM(vmm, "   %010llx %016llx",
+				 pt->addr + (ptei + i) * 8, data);
+			buf[i * 2 + 0] = lower_32_bits(data);
+			buf[i * 2 + 1] = upper_32_bits(data);
+			map->type += map->ctag;
+		}
+
+		nvkm_vmm_pte_copy(pt, ptei, buf, nr);
+		ptei += nr;
+		ptes -= nr;
+	}
+}
+
 static inline struct nvkm_vma *
 nvkm_vma_new(u64 addr, u64 size)
 {
@@ -767,15 +956,100 @@ nvkm_vma_tail(struct nvkm_vma *vma, u64 tail)
 	return new;
 }
 
+/* Alignment classes tracked by the free tree, chosen to match the page
+ * sizes commonly requested from the various MMU backends.
+ */
+static const u8
+nvkm_vmm_free_align[NVKM_VMA_FREE_NR] = { 12, 16, 17, 21 };
+
+static inline u64
+nvkm_vmm_free_size(struct nvkm_vma *vma, u8 align)
+{
+	const u64 addr = ALIGN(vma->addr, 1ULL << align);
+	const u64 tail = vma->addr + vma->size;
+	return addr < tail ? tail - addr : 0;
+}
+
+static inline u64
+nvkm_vmm_free_max(struct rb_node *node, int c)
+{
+	return node ? rb_entry(node, struct nvkm_vma, tree)->free[c] : 0;
+}
+
+static bool
+nvkm_vmm_free_compute(struct nvkm_vma *vma, bool exit)
+{
+	bool same = true;
+	int c;
+
+	for (c = 0; c < NVKM_VMA_FREE_NR; c++) {
+		u64 free = nvkm_vmm_free_size(vma, nvkm_vmm_free_align[c]);
+		free = max(free, nvkm_vmm_free_max(vma->tree.rb_left, c));
+		free = max(free, nvkm_vmm_free_max(vma->tree.rb_right, c));
+		if (vma->free[c] != free) {
+			vma->free[c] = free;
+			same = false;
+		}
+	}
+
+	return exit && same;
+}
+
+static void
+nvkm_vmm_free_propagate(struct rb_node *node, struct rb_node *stop)
+{
+	while (node != stop) {
+		struct nvkm_vma *vma = rb_entry(node, typeof(*vma), tree);
+		if (nvkm_vmm_free_compute(vma, true))
+			break;
+		node = rb_parent(node);
+	}
+}
+
+static void
+nvkm_vmm_free_copy(struct rb_node *rb_old, struct rb_node *rb_new)
+{
+	struct nvkm_vma *old = rb_entry(rb_old, typeof(*old), tree);
+	struct nvkm_vma *new = rb_entry(rb_new, typeof(*new), tree);
+	memcpy(new->free, old->free, sizeof(new->free));
+}
+
+static void
+nvkm_vmm_free_rotate(struct rb_node *rb_old, struct rb_node *rb_new)
+{
+	struct nvkm_vma *old = rb_entry(rb_old, typeof(*old), tree);
+	nvkm_vmm_free_copy(rb_old, rb_new);
+	nvkm_vmm_free_compute(old, false);
+}
+
+static const struct rb_augment_callbacks
+nvkm_vmm_free_augment = {
+	.propagate = nvkm_vmm_free_propagate,
+	.copy = nvkm_vmm_free_copy,
+	.rotate = nvkm_vmm_free_rotate,
+};
+
+static void
+nvkm_vmm_free_delete(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
+{
+	rb_erase_augmented(&vma->tree, &vmm->free, &nvkm_vmm_free_augment);
+}
+
 static void
 nvkm_vmm_free_insert(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 {
 	struct rb_node **ptr = &vmm->free.rb_node;
 	struct rb_node *parent = NULL;
+	int c;
+
+	for (c = 0; c < NVKM_VMA_FREE_NR; c++)
+		vma->free[c] = nvkm_vmm_free_size(vma, nvkm_vmm_free_align[c]);
 
 	while (*ptr) {
 		struct nvkm_vma *this = rb_entry(*ptr, typeof(*this), tree);
 		parent = *ptr;
+		for (c = 0; c < NVKM_VMA_FREE_NR; c++)
+			this->free[c] = max(this->free[c], vma->free[c]);
 		if (vma->size < this->size)
 			ptr = &parent->rb_left;
 		else
@@ -792,7 +1066,82 @@ nvkm_vmm_free_insert(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 	}
 
 	rb_link_node(&vma->tree, parent, ptr);
-	rb_insert_color(&vma->tree, &vmm->free);
+	rb_insert_augmented(&vma->tree, &vmm->free, &nvkm_vmm_free_augment);
+}
+
+/* Locate the smallest block in a subtree of the free tree that's large
+ * enough to satisfy an allocation after alignment, using the augmented
+ * data to skip over subtrees that can't possibly contain one.
+ *
+ * The augmented sizes are only exact when the requested alignment is the
+ * class' own.  Otherwise they're an upper bound, and a left subtree that
+ * looks usable may not be, so it's searched before falling back to this
+ * node and its right subtree.
+ */
+static struct rb_node *
+nvkm_vmm_free_first(struct rb_node *node, int c, u8 align, u64 size)
+{
+	struct rb_node *left;
+
+	while (nvkm_vmm_free_max(node, c) >= size) {
+		struct nvkm_vma *this = rb_entry(node, typeof(*this), tree);
+		if (nvkm_vmm_free_align[c] == align) {
+			if (nvkm_vmm_free_max(node->rb_left, c) >= size) {
+				node = node->rb_left;
+				continue;
+			}
+		} else {
+			left = nvkm_vmm_free_first(node->rb_left, c, align, size);
+			if (left)
+				return left;
+		}
+
+		if (nvkm_vmm_free_size(this, align) >= size)
+			return node;
+		node = node->rb_right;
+	}
+	return NULL;
+}
+
+static struct rb_node *
+nvkm_vmm_free_next(struct rb_node *node, int c, u8 align, u64 size)
+{
+	struct rb_node *next, *parent;
+
+	if ((next = nvkm_vmm_free_first(node->rb_right, c, align, size)))
+		return next;
+
+	while ((parent = rb_parent(node))) {
+		if (node == parent->rb_left) {
+			struct nvkm_vma *this = rb_entry(parent, typeof(*this), tree);
+			if (nvkm_vmm_free_size(this, align) >= size)
+				return parent;
+			next = nvkm_vmm_free_first(parent->rb_right, c, align, size);
+			if (next)
+				return next;
+		}
+		node = parent;
+	}
+
+	return NULL;
+}
+
+/* Changes to the tree of allocated VMAs (and the size of its nodes) must
+ * be bracketed by these, so nvkm_vmm_node_lookup() can detect them.  The
+ * sections nest, so a larger operation can appear atomic to readers.
+ */
+void
+nvkm_vmm_node_write_begin(struct nvkm_vmm *vmm)
+{
+	if (!vmm->lookup.depth++)
+		write_seqcount_begin(&vmm->lookup.seq);
+}
+
+void
+nvkm_vmm_node_write_end(struct nvkm_vmm *vmm)
+{
+	if (!WARN_ON(!vmm->lookup.depth) && !--vmm->lookup.depth)
+		write_seqcount_end(&vmm->lookup.seq);
 }
 
 void
@@ -801,6 +1150,7 @@ nvkm_vmm_node_insert(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 	struct rb_node **ptr = &vmm->root.rb_node;
 	struct rb_node *parent = NULL;
 
+	nvkm_vmm_node_write_begin(vmm);
 	while (*ptr) {
 		struct nvkm_vma *this = rb_entry(*ptr, typeof(*this), tree);
 		parent = *ptr;
@@ -815,6 +1165,7 @@ nvkm_vmm_node_insert(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 
 	rb_link_node(&vma->tree, parent, ptr);
 	rb_insert_color(&vma->tree, &vmm->root);
+	nvkm_vmm_node_write_end(vmm);
 }
 
 struct nvkm_vma *
@@ -834,16 +1185,56 @@ nvkm_vmm_node_search(struct nvkm_vmm *vmm, u64 addr)
 	return NULL;
 }
 
+/* Lookup of an allocated VMA that doesn't take vmm->mutex, and so can be
+ * used from contexts that can't sleep (ie. fault handling), or shouldn't
+ * wait behind a long-running map operation.
+ *
+ * Readers retry if the tree is modified underneath them, and give up with
+ * -EAGAIN rather than spin on a writer that may have been preempted.
+ */
+int
+nvkm_vmm_node_lookup(struct nvkm_vmm *vmm, u64 addr, struct nvkm_vma_info *info)
+{
+	struct nvkm_vma *vma;
+	unsigned seq;
+	int retry;
+
+	rcu_read_lock();
+	for (retry = 0; retry < 16; retry++) {
+		if ((seq = raw_read_seqcount(&vmm->lookup.seq)) & 1) {
+			cpu_relax();
+			continue;
+		}
+
+		if ((vma = nvkm_vmm_node_search(vmm, addr))) {
+			info->addr = vma->addr;
+			info->size = vma->size;
+			info->mapped = vma->memory != NULL;
+			info->sparse = vma->sparse;
+			info->user = vma->user;
+		}
+
+		if (!read_seqcount_retry(&vmm->lookup.seq, seq)) {
+			rcu_read_unlock();
+			return vma ? 0 : -ENOENT;
+		}
+	}
+	rcu_read_unlock();
+	return -EAGAIN;
+}
+
 static void
 nvkm_vmm_dtor(struct nvkm_vmm *vmm)
 {
 	struct nvkm_vma *vma;
 	struct rb_node *node;
 
+	nvkm_vmm_flush_begin(vmm);
 	while ((node = rb_first(&vmm->root))) {
 		struct nvkm_vma *vma = rb_entry(node, typeof(*vma), tree);
 		nvkm_vmm_put(vmm, &vma);
 	}
+	nvkm_vmm_flush_commit(vmm);
 
 	if (vmm->bootstrapped) {
 		const struct nvkm_vmm_page *page = vmm->func->page;
@@ -856,6 +1247,11 @@ nvkm_vmm_dtor(struct nvkm_vmm *vmm)
 		nvkm_vmm_ptes_put(vmm, page, vmm->start, limit);
 	}
 
+	VMM_DEBUG(vmm, "flushes: %llu issued, %llu avoided",
+		  vmm->flush.issued, vmm->flush.avoided);
+	VMM_DEBUG(vmm, "promoted: %lld maps, %lld bytes",
+		  vmm->promote.maps, vmm->promote.bytes);
+
 	vma = list_first_entry(&vmm->list, typeof(*vma), head);
 	list_del(&vma->head);
 	kfree(vma);
@@ -882,11 +1278,14 @@ nvkm_vmm_ctor(const struct nvkm_vmm_func *func, struct nvkm_mmu *mmu,
 	const struct nvkm_vmm_desc *desc;
 	struct nvkm_vma *vma;
 	int levels, bits = 0;
+	u32 prewarm;
 
 	vmm->func = func;
 	vmm->mmu = mmu;
 	vmm->name = name;
 	vmm->debug = mmu->subdev.debug;
+	vmm->flush.depth = NVKM_VMM_LEVELS_MAX;
+	INIT_LIST_HEAD(&vmm->flush.release);
 	kref_init(&vmm->kref);
 
 	__mutex_init(&vmm->mutex, "&vmm->mutex", key ? key : &_key);
@@ -929,12 +1328,30 @@ nvkm_vmm_ctor(const struct nvkm_vmm_func *func, struct nvkm_mmu *mmu,
 		vmm->pd->pt[0] = nvkm_mmu_ptc_get(mmu, size, desc->align, true);
 		if (!vmm->pd->pt[0])
 			return -ENOMEM;
+		vmm->pt_bytes += size;
+	}
+
+	/* Opt-in to mapping contiguous memory with larger pages than the
+	 * memory object was allocated with.
+	 */
+	vmm->promote.enabled = nvkm_boolopt(mmu->subdev.device->cfgopt,
+					    "NvMmuPromote", false);
+
+	/* Optionally pre-allocate page tables for the lower levels. */
+	prewarm = nvkm_longopt(mmu->subdev.device->cfgopt,
+			       "NvMmuPtcPrewarm", 0);
+	for (page = func->page; prewarm && page->shift; page++) {
+		for (desc = page->desc; desc[1].bits; desc++) {
+			nvkm_mmu_ptc_prewarm(mmu, desc->size << desc->bits,
+					     desc->align, prewarm);
+		}
 	}
 
 	/* Initialise address-space MM. */
 	INIT_LIST_HEAD(&vmm->list);
 	vmm->free = RB_ROOT;
 	vmm->root = RB_ROOT;
+	seqcount_init(&vmm->lookup.seq);
 
 	if (!(vma = nvkm_vma_new(vmm->start, vmm->limit - vmm->start)))
 		return -ENOMEM;
@@ -962,16 +1379,16 @@ nvkm_vmm_unmap_region(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 {
 	struct nvkm_vma *next;
 
-	nvkm_memory_tags_put(vma->memory, vmm->mmu->subdev.device, &vma->tags);
-	nvkm_memory_unref(&vma->memory);
+	nvkm_vmm_release(vmm, &vma->memory, &vma->tags);
 
+	nvkm_vmm_node_write_begin(vmm);
 	if (vma->part) {
 		struct nvkm_vma *prev = node(vma, prev);
 		if (!prev->memory) {
 			prev->size += vma->size;
 			rb_erase(&vma->tree, &vmm->root);
 			list_del(&vma->head);
-			kfree(vma);
+			kfree_rcu(vma, rcu);
 			vma = prev;
 		}
 	}
@@ -982,9 +1399,10 @@ nvkm_vmm_unmap_region(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 			vma->size += next->size;
 			rb_erase(&next->tree, &vmm->root);
 			list_del(&next->head);
-			kfree(next);
+			kfree_rcu(next, rcu);
 		}
 	}
+	nvkm_vmm_node_write_end(vmm);
 }
 
 void
@@ -1012,6 +1430,58 @@ nvkm_vmm_unmap(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 	}
 }
 
+/* Determine whether the memory backing a mapping is made up entirely of
+ * physically contiguous, naturally aligned, blocks of a given page size,
+ * even though the memory object itself doesn't guarantee it.
+ */
+static bool
+nvkm_vmm_map_contig(struct nvkm_vmm_map *map, u64 size, u8 shift)
+{
+	const u64 mask = (1ULL << shift) - 1;
+	u64 off = map->offset;
+
+	if (map->mem) {
+		struct nvkm_mm_node *mem;
+		for (mem = map->mem; mem && size; mem = mem->next) {
+			u64 addr = (u64)mem->offset << NVKM_RAM_MM_SHIFT;
+			u64 part = (u64)mem->length << NVKM_RAM_MM_SHIFT;
+			if (off >= part) {
+				off -= part;
+				continue;
+			}
+			addr += off;
+			part = min(part - off, size);
+			off = 0;
+			if ((addr | part) & mask)
+				return false;
+			size -= part;
+		}
+		return !size;
+	}
+
+	if (map->sgl) {
+		struct scatterlist *sgl;
+		for (sgl = map->sgl; sgl && size; sgl = sg_next(sgl)) {
+			u64 addr = sg_dma_address(sgl);
+			u64 part = sg_dma_len(sgl);
+			if (off >= part) {
+				off -= part;
+				continue;
+			}
+			addr += off;
+			part = min(part - off, size);
+			off = 0;
+			if ((addr | part) & mask)
+				return false;
+			size -= part;
+		}
+		return !size;
+	}
+
+	/* DMA address arrays are only handled at PAGE_SIZE granularity. */
+	return false;
+}
+
 static int
 nvkm_vmm_map_valid(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 		   void *argv, u32 argc, struct nvkm_vmm_map *map)
@@ -1038,7 +1508,9 @@ nvkm_vmm_map_valid(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 	if (!IS_ALIGNED(     vma->addr, 1ULL << map->page->shift) ||
 	    !IS_ALIGNED((u64)vma->size, 1ULL << map->page->shift) ||
 	    !IS_ALIGNED(   map->offset, 1ULL << map->page->shift) ||
-	    nvkm_memory_page(map->memory) < map->page->shift) {
+	    (nvkm_memory_page(map->memory) < map->page->shift &&
+	     !(vmm->promote.enabled && vma->page == NVKM_VMA_PAGE_NONE &&
+	       nvkm_vmm_map_contig(map, vma->size, map->page->shift)))) {
 		VMM_DEBUG(vmm, "alignment %016llx %016llx %016llx %d %d",
 		    vma->addr, (u64)vma->size, map->offset, map->page->shift,
 		    nvkm_memory_page(map->memory));
@@ -1060,7 +1532,7 @@ nvkm_vmm_map_choose(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 	return -EINVAL;
 }
 
-static int
+int
 nvkm_vmm_map_locked(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 		    void *argv, u32 argc, struct nvkm_vmm_map *map)
 {
@@ -1088,6 +1560,16 @@ nvkm_vmm_map_locked(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 			nvkm_vmm_map_choose(vmm, vma, argv, argc, map);
 			return -EINVAL;
 		}
+
+		/* Memory turned out to be suitable for a larger page size
+		 * than it was allocated with.
+		 */
+		if (nvkm_memory_page(map->memory) < map->page->shift) {
+			VMM_DEBUG(vmm, "promoted %016llx %016llx to %d",
+				  vma->addr, (u64)vma->size, map->page->shift);
+			vmm->promote.maps++;
+			vmm->promote.bytes += vma->size;
+		}
 	} else {
 		/* Page size of the VMA is already pre-determined. */
 		if (vma->refd != NVKM_VMA_PAGE_NONE)
@@ -1138,10 +1620,16 @@ nvkm_vmm_map_locked(struct nvkm_vmm *vmm, struct nvkm_vma *vma,
 		nvkm_vmm_ptes_map(vmm, map->page, vma->addr, vma->size, map, func);
 	}
 
-	nvkm_memory_tags_put(vma->memory, vmm->mmu->subdev.device, &vma->tags);
-	nvkm_memory_unref(&vma->memory);
+	/* Any previous mapping is released once its PTEs are flushed. */
+	nvkm_vmm_release(vmm, &vma->memory, &vma->tags);
 	vma->memory = nvkm_memory_ref(map->memory);
 	vma->tags = map->tags;
+
+	/* Wait for any comptag clear, batched with others if deferred. */
+	if (vma->tags && vma->tags->clear)
+		vmm->flush.tags = max(vmm->flush.tags, vma->tags->clear);
+	if (!vmm->flush.defer)
+		nvkm_vmm_flush_tags(vmm);
 	return 0;
 }
 
@@ -1150,6 +1638,7 @@ nvkm_vmm_map(struct nvkm_vmm *vmm, struct nvkm_vma *vma, void *argv, u32 argc,
 	     struct nvkm_vmm_map *map)
 {
 	int ret;
+
 	mutex_lock(&vmm->mutex);
 	ret = nvkm_vmm_map_locked(vmm, vma, argv, argc, map);
 	vma->busy = false;
@@ -1163,18 +1652,18 @@ nvkm_vmm_put_region(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 	struct nvkm_vma *prev, *next;
 
 	if ((prev = node(vma, prev)) && !prev->used) {
-		rb_erase(&prev->tree, &vmm->free);
+		nvkm_vmm_free_delete(vmm, prev);
 		list_del(&prev->head);
 		vma->addr  = prev->addr;
 		vma->size += prev->size;
-		kfree(prev);
+		kfree_rcu(prev, rcu);
 	}
 
 	if ((next = node(vma, next)) && !next->used) {
-		rb_erase(&next->tree, &vmm->free);
+		nvkm_vmm_free_delete(vmm, next);
 		list_del(&next->head);
 		vma->size += next->size;
-		kfree(next);
+		kfree_rcu(next, rcu);
 	}
 
 	nvkm_vmm_free_insert(vmm, vma);
@@ -1188,6 +1677,11 @@ nvkm_vmm_put_locked(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 
 	BUG_ON(vma->part);
 
+	/* Unmapping, unsparsing and dereferencing may each walk the page
+	 * tree, only invalidate once at the end.
+	 */
+	nvkm_vmm_flush_begin(vmm);
+
 	if (vma->mapref || !vma->sparse) {
 		do {
 			const bool map = next->memory != NULL;
@@ -1249,8 +1743,12 @@ nvkm_vmm_put_locked(struct nvkm_vmm *vmm, struct nvkm_vma *vma)
 		nvkm_vmm_ptes_sparse(vmm, vma->addr, vma->size, false);
 	}
 
+	nvkm_vmm_flush_commit(vmm);
+
 	/* Remove VMA from the list of allocated nodes. */
+	nvkm_vmm_node_write_begin(vmm);
 	rb_erase(&vma->tree, &vmm->root);
+	nvkm_vmm_node_write_end(vmm);
 
 	/* Merge VMA back into the free list. */
 	vma->page = NVKM_VMA_PAGE_NONE;
@@ -1277,10 +1775,10 @@ nvkm_vmm_get_locked(struct nvkm_vmm *vmm, bool getref, bool mapref, bool sparse,
 		    u8 shift, u8 align, u64 size, struct nvkm_vma **pvma)
 {
 	const struct nvkm_vmm_page *page = &vmm->func->page[NVKM_VMA_PAGE_NONE];
-	struct rb_node *node = NULL, *temp;
 	struct nvkm_vma *vma = NULL, *tmp;
+	struct rb_node *node;
 	u64 addr, tail;
-	int ret;
+	int ret, c;
 
 	VMM_TRACE(vmm, "getref %d mapref %d sparse %d "
 		       "shift: %d align: %d size: %016llx",
@@ -1323,25 +1821,20 @@ nvkm_vmm_get_locked(struct nvkm_vmm *vmm, bool getref, bool mapref, bool sparse,
 		align = max_t(u8, align, 12);
 	}
 
-	/* Locate smallest block that can possibly satisfy the allocation. */
-	temp = vmm->free.rb_node;
-	while (temp) {
-		struct nvkm_vma *this = rb_entry(temp, typeof(*this), tree);
-		if (this->size < size) {
-			temp = temp->rb_right;
-		} else {
-			node = temp;
-			temp = temp->rb_left;
-		}
-	}
-
-	if (unlikely(!node))
-		return -ENOSPC;
+	/* Locate the smallest block that can satisfy the allocation once
+	 * alignment is taken into account.  The free tree tracks a number
+	 * of alignment classes, the largest one not exceeding the request
+	 * is used to prune the search, with the exact alignment checked
+	 * against each candidate.
+	 */
+	for (c = NVKM_VMA_FREE_NR - 1; nvkm_vmm_free_align[c] > align; c--);
+	node = nvkm_vmm_free_first(vmm->free.rb_node, c, align, size);
 
-	/* Take into account alignment restrictions, trying larger blocks
-	 * in turn until we find a suitable free block.
+	/* Tesla's page_block restrictions depend on the neighbouring VMAs,
+	 * so these can't be tracked in the tree, try larger blocks in turn
+	 * if the candidate doesn't satisfy them.
 	 */
-	do {
+	while (node) {
 		struct nvkm_vma *this = rb_entry(node, typeof(*this), tree);
 		struct nvkm_vma *prev = node(this, prev);
 		struct nvkm_vma *next = node(this, next);
@@ -1354,14 +1847,16 @@ nvkm_vmm_get_locked(struct nvkm_vmm *vmm, bool getref, bool mapref, bool sparse,
 
 		tail = this->addr + this->size;
 		if (vmm->func->page_block && next && next->page != p)
-			tail = ALIGN_DOWN(addr, vmm->func->page_block);
+			tail = ALIGN_DOWN(tail, vmm->func->page_block);
 
 		if (addr <= tail && tail - addr >= size) {
-			rb_erase(&this->tree, &vmm->free);
+			nvkm_vmm_free_delete(vmm, this);
 			vma = this;
 			break;
 		}
-	} while ((node = rb_next(node)));
+
+		node = nvkm_vmm_free_next(node, c, align, size);
+	}
 
 	if (unlikely(!vma))
 		return -ENOSPC;
@@ -1386,7 +1881,15 @@ nvkm_vmm_get_locked(struct nvkm_vmm *vmm, bool getref, bool mapref, bool sparse,
 		nvkm_vmm_free_insert(vmm, tmp);
 	}
 
-	/* Pre-allocate page tables and/or setup sparse mappings. */
+	/* Pre-allocate page tables and/or setup sparse mappings, which may
+	 * take multiple walks of the page tree at different page sizes.
+	 *
+	 * Sparse regions without up-front references are already lazy, see
+	 * nvkm_vmm_ptes_sparse().  Requesting references (PTES) allocates
+	 * every PT in the range at the given page size, as that's what
+	 * guarantees later maps can't fail with -ENOMEM.
+	 */
+	nvkm_vmm_flush_begin(vmm);
 	if (sparse && getref)
 		ret = nvkm_vmm_ptes_sparse_get(vmm, page, vma->addr, vma->size);
 	else if (sparse)
@@ -1395,6 +1898,7 @@ nvkm_vmm_get_locked(struct nvkm_vmm *vmm, bool getref, bool mapref, bool sparse,
 		ret = nvkm_vmm_ptes_get(vmm, page, vma->addr, vma->size);
 	else
 		ret = 0;
+	nvkm_vmm_flush_commit(vmm);
 	if (ret) {
 		nvkm_vmm_put_region(vmm, vma);
 		return ret;
@@ -1471,6 +1975,136 @@ nvkm_vmm_boot(struct nvkm_vmm *vmm)
 	return 0;
 }
 
+/* Find the descriptor for a PT at the given depth from the root, based
+ * on the page size it was created for.  PTs allocated without one (ie.
+ * the root PD) use the smallest page size, which covers every level.
+ */
+static const struct nvkm_vmm_desc *
+nvkm_vmm_footprint_desc(struct nvkm_vmm *vmm, u8 shift, int depth,
+			const struct nvkm_vmm_page **ppage, int *plvl)
+{
+	const struct nvkm_vmm_page *page = vmm->func->page;
+	int lvl;
+
+	while (page->shift != shift && page[1].shift)
+		page++;
+
+	for (lvl = 0; page->desc[lvl].bits; lvl++);
+	if (depth >= lvl) {
+		while (page[1].shift)
+			page++;
+		for (lvl = 0; page->desc[lvl].bits; lvl++);
+	}
+
+	*ppage = page;
+	*plvl = lvl - 1 - depth;
+	return &page->desc[*plvl];
+}
+
+static void
+nvkm_vmm_footprint_pt(struct nvkm_vmm *vmm, struct nvkm_vmm_pt *pgt,
+		      int depth, struct nvkm_vmm_footprint *fp)
+{
+	struct nvkm_vmm_footprint_level *level = &fp->level[depth];
+	const struct nvkm_vmm_desc *desc, *pair[2];
+	const struct nvkm_vmm_page *page;
+	u32 pten, pdei, lpte = 0;
+	int lvl, i;
+
+	desc = nvkm_vmm_footprint_desc(vmm, pgt->page, depth, &page, &lvl);
+	pten = 1 << desc->bits;
+
+	/* Dual PTs track the LPT in pt[0], and the SPT in pt[1]. */
+	pair[0] = pair[1] = desc;
+	if (desc->type == SPT) {
+		pair[0] = &page[-1].desc[lvl];
+		lpte = pten >> (desc->bits - pair[0]->bits);
+	} else
+	if (desc->type == LPT) {
+		pair[1] = &page[1].desc[lvl];
+		lpte = pten;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(pgt->pt); i++) {
+		if (pgt->pt[i]) {
+			level->bytes += (u64)pair[i]->size << pair[i]->bits;
+			level->hwpts++;
+		}
+	}
+
+	level->tables++;
+	level->refs += pgt->refs[0] + pgt->refs[1];
+	level->sparse += pgt->sparse;
+	level->swbytes += sizeof(*pgt) + lpte;
+	if (desc->type != PGD || !pgt->pde)
+		return;
+
+	level->swbytes += sizeof(*pgt->pde) * pten;
+	for (pdei = 0; pdei < pten; pdei++) {
+		struct nvkm_vmm_pt *pde = pgt->pde[pdei];
+		if (NVKM_VMM_PDE_SPARSED(pde))
+			level->sparse++;
+		else
+		if (pde && depth + 1 < fp->level_nr)
+			nvkm_vmm_footprint_pt(vmm, pde, depth + 1, fp);
+	}
+}
+
+static void
+nvkm_vmm_footprint_run(struct nvkm_vmm_footprint *fp, bool mapped,
+		       u64 addr, u64 size)
+{
+	if (mapped && size > fp->mapped_size) {
+		fp->mapped_addr = addr;
+		fp->mapped_size = size;
+	} else
+	if (!mapped && size > fp->unmapped_size) {
+		fp->unmapped_addr = addr;
+		fp->unmapped_size = size;
+	}
+}
+
+void
+nvkm_vmm_footprint(struct nvkm_vmm *vmm, struct nvkm_vmm_footprint *fp)
+{
+	const struct nvkm_vmm_page *page;
+	struct nvkm_vma *vma;
+	u64 addr = vmm->start, size = 0;
+	bool mapped = false;
+	int lvl, i;
+
+	memset(fp, 0x00, sizeof(*fp));
+
+	for (page = vmm->func->page; page->shift; page++)
+		fp->page_nr++;
+	for (lvl = 0; page[-1].desc[lvl].bits; lvl++);
+	fp->level_nr = lvl;
+	for (i = 0; i < fp->level_nr; i++)
+		fp->level[i].desc = &page[-1].desc[lvl - 1 - i];
+
+	mutex_lock(&vmm->mutex);
+	if (vmm->pd)
+		nvkm_vmm_footprint_pt(vmm, vmm->pd, 0, fp);
+
+	list_for_each_entry(vma, &vmm->list, head) {
+		const bool map = vma->memory != NULL;
+
+		if (map != mapped || vma->addr != addr + size) {
+			nvkm_vmm_footprint_run(fp, mapped, addr, size);
+			mapped = map;
+			addr = vma->addr;
+			size = 0;
+		}
+
+		if (map && vma->refd != NVKM_VMA_PAGE_NONE)
+			fp->page[vma->refd] += vma->size;
+		size += vma->size;
+	}
+
+	nvkm_vmm_footprint_run(fp, mapped, addr, size);
+	mutex_unlock(&vmm->mutex);
+}
+
 static void
 nvkm_vmm_del(struct kref *kref)
 {
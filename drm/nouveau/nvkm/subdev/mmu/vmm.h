@@ -4,6 +4,8 @@
 #include <core/memory.h>
 enum nvkm_memory_target;
 
+#define NVKM_VMM_LEVELS_MAX 5
+
 struct nvkm_vmm_pt {
 	/* Some GPUs have a mapping level with a dual page tables to
 	 * support large and small pages in the same address-range.
@@ -150,6 +152,11 @@ struct nvkm_vmm_join {
 	struct list_head head;
 };
 
+void nvkm_vmm_pte_run64(struct nvkm_vmm *, struct nvkm_mmu_pt *, u32 ptei,
+			u32 ptes, u64 data, u64 next);
+void nvkm_vmm_pte_dma64(struct nvkm_vmm *, struct nvkm_mmu_pt *, u32 ptei,
+			u32 ptes, struct nvkm_vmm_map *, int shift);
+
 int nvkm_vmm_new_(const struct nvkm_vmm_func *, struct nvkm_mmu *,
 		  u32 pd_header, u64 addr, u64 size, struct lock_class_key *,
 		  const char *name, struct nvkm_vmm **);
@@ -163,9 +170,39 @@ int nvkm_vmm_get_locked(struct nvkm_vmm *, bool getref, bool mapref,
 void nvkm_vmm_put_locked(struct nvkm_vmm *, struct nvkm_vma *);
 void nvkm_vmm_unmap_locked(struct nvkm_vmm *, struct nvkm_vma *);
 void nvkm_vmm_unmap_region(struct nvkm_vmm *vmm, struct nvkm_vma *vma);
+void nvkm_vmm_flush_begin(struct nvkm_vmm *);
+void nvkm_vmm_flush_commit(struct nvkm_vmm *);
+
+struct nvkm_vmm_footprint {
+	/* Page-table tree, indexed by depth (0 is the root). */
+	int level_nr;
+	struct nvkm_vmm_footprint_level {
+		const struct nvkm_vmm_desc *desc;
+		u32 tables; /* Software PTs. */
+		u32 hwpts; /* Hardware PTs, dual PTs count individually. */
+		u32 sparse; /* Sparse PTs, and PDEs marked sparse. */
+		u64 refs; /* Referenced entries. */
+		u64 bytes; /* Hardware PT memory. */
+		u64 swbytes; /* Software tracking memory. */
+	} level[NVKM_VMM_LEVELS_MAX];
+
+	/* Address-space mapped with each page size. */
+	int page_nr;
+	u64 page[NVKM_VMA_PAGE_NONE];
+
+	/* Largest runs of mapped/unmapped address-space. */
+	u64 mapped_addr;
+	u64 mapped_size;
+	u64 unmapped_addr;
+	u64 unmapped_size;
+};
+
+void nvkm_vmm_footprint(struct nvkm_vmm *, struct nvkm_vmm_footprint *);
 
 struct nvkm_vma *nvkm_vma_tail(struct nvkm_vma *, u64 tail);
 void nvkm_vmm_node_insert(struct nvkm_vmm *, struct nvkm_vma *);
+void nvkm_vmm_node_write_begin(struct nvkm_vmm *);
+void nvkm_vmm_node_write_end(struct nvkm_vmm *);
 
 int nv04_vmm_new_(const struct nvkm_vmm_func *, struct nvkm_mmu *, u32,
 		  u64, u64, void *, u32, struct lock_class_key *,
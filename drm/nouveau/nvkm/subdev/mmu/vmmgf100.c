@@ -46,11 +46,7 @@ gf100_vmm_pgt_pte(struct nvkm_vmm *vmm, struct nvkm_mmu_pt *pt,
 		}
 	} else {
 		map->type += ptes * map->ctag;
-
-		while (ptes--) {
-			VMM_WO064(pt, vmm, ptei++ * 8, data);
-			data += map->next;
-		}
+		nvkm_vmm_pte_run64(vmm, pt, ptei, ptes, data, map->next);
 	}
 }
 
@@ -68,11 +64,7 @@ gf100_vmm_pgt_dma(struct nvkm_vmm *vmm, struct nvkm_mmu_pt *pt,
 	if (map->page->shift == PAGE_SHIFT) {
 		VMM_SPAM(vmm, "DMAA %08x %08x PTE(s)", ptei, ptes);
 		nvkm_kmap(pt->memory);
-		while (ptes--) {
-			const u64 data = (*map->dma++ >> 8) | map->type;
-			VMM_WO064(pt, vmm, ptei++ * 8, data);
-			map->type += map->ctag;
-		}
+		nvkm_vmm_pte_dma64(vmm, pt, ptei, ptes, map, 8);
 		nvkm_done(pt->memory);
 		return;
 	}
@@ -276,8 +268,8 @@ gf100_vmm_valid(struct nvkm_vmm *vmm, void *argv, u32 argc,
 			return ret;
 		}
 
-		if (map->tags->mn) {
-			u64 tags = map->tags->mn->offset + (map->offset >> 17);
+		if (map->tags->nr) {
+			u64 tags = map->tags->offset + (map->offset >> 17);
 			if (page->shift == 17 || !gm20x) {
 				map->type |= tags << 44;
 				map->ctag |= 1ULL << 44;
@@ -34,11 +34,7 @@ gp100_vmm_pgt_pte(struct nvkm_vmm *vmm, struct nvkm_mmu_pt *pt,
 	u64 data = (addr >> 4) | map->type;
 
 	map->type += ptes * map->ctag;
-
-	while (ptes--) {
-		VMM_WO064(pt, vmm, ptei++ * 8, data);
-		data += map->next;
-	}
+	nvkm_vmm_pte_run64(vmm, pt, ptei, ptes, data, map->next);
 }
 
 static void
@@ -55,11 +51,7 @@ gp100_vmm_pgt_dma(struct nvkm_vmm *vmm, struct nvkm_mmu_pt *pt,
 	if (map->page->shift == PAGE_SHIFT) {
 		VMM_SPAM(vmm, "DMAA %08x %08x PTE(s)", ptei, ptes);
 		nvkm_kmap(pt->memory);
-		while (ptes--) {
-			const u64 data = (*map->dma++ >> 4) | map->type;
-			VMM_WO064(pt, vmm, ptei++ * 8, data);
-			map->type += map->ctag;
-		}
+		nvkm_vmm_pte_dma64(vmm, pt, ptei, ptes, map, 4);
 		nvkm_done(pt->memory);
 		return;
 	}
@@ -287,8 +279,8 @@ gp100_vmm_valid(struct nvkm_vmm *vmm, void *argv, u32 argc,
 			return ret;
 		}
 
-		if (map->tags->mn) {
-			tags = map->tags->mn->offset + (map->offset >> 16);
+		if (map->tags->nr) {
+			tags = map->tags->offset + (map->offset >> 16);
 			map->ctag |= ((1ULL << page->shift) >> 16) << 36;
 			map->type |= tags << 36;
 			map->next |= map->ctag;
@@ -304,8 +304,8 @@ nv50_vmm_valid(struct nvkm_vmm *vmm, void *argv, u32 argc,
 			return ret;
 		}
 
-		if (map->tags->mn) {
-			u32 tags = map->tags->mn->offset + (map->offset >> 16);
+		if (map->tags->nr) {
+			u32 tags = map->tags->offset + (map->offset >> 16);
 			map->ctag |= (u64)comp << 49;
 			map->type |= (u64)comp << 47;
 			map->type |= (u64)tags << 49;
@@ -11,18 +11,30 @@ struct nvkm_memx {
 		u32 size;
 		u32 data[64];
 	} c;
+
+	/* Script is built in system memory, and uploaded on exec. */
+	u32 *data;
+	u32 words;
+	bool overflow;
+
+	bool merge; /* Last command is a write that may be merged into. */
+	u32 wr32;
+	u32 merged;
 };
 
 static void
 memx_out(struct nvkm_memx *memx)
 {
-	struct nvkm_device *device = memx->pmu->subdev.device;
-	int i;
-
 	if (memx->c.mthd) {
-		nvkm_wr32(device, 0x10a1c4, (memx->c.size << 16) | memx->c.mthd);
-		for (i = 0; i < memx->c.size; i++)
-			nvkm_wr32(device, 0x10a1c4, memx->c.data[i]);
+		if (memx->words + 1 + memx->c.size > memx->size / 4) {
+			memx->overflow = true;
+		} else {
+			memx->data[memx->words++] = (memx->c.size << 16) |
+						    memx->c.mthd;
+			memcpy(&memx->data[memx->words], memx->c.data,
+			       memx->c.size * sizeof(memx->c.data[0]));
+			memx->words += memx->c.size;
+		}
 		memx->c.mthd = 0;
 		memx->c.size = 0;
 	}
@@ -31,6 +43,9 @@ memx_out(struct nvkm_memx *memx)
 static void
 memx_cmd(struct nvkm_memx *memx, u32 mthd, u32 size, u32 data[])
 {
+	if (mthd != MEMX_WR32)
+		memx->merge = false;
+
 	if ((memx->c.size + size >= ARRAY_SIZE(memx->c.data)) ||
 	    (memx->c.mthd && memx->c.mthd != mthd))
 		memx_out(memx);
@@ -39,10 +54,90 @@ memx_cmd(struct nvkm_memx *memx, u32 mthd, u32 size, u32 data[])
 	memx->c.mthd  = mthd;
 }
 
+/* Heuristic: sync to head with biggest resolution. */
+static int
+memx_vblank_head(struct nvkm_pmu *pmu)
+{
+	struct nvkm_device *device = pmu->subdev.device;
+	u32 heads, x, y, px = 0;
+	int i, head_sync = -1;
+
+	if (device->chipset < 0xd0) {
+		heads = nvkm_rd32(device, 0x610050);
+		for (i = 0; i < 2; i++) {
+			if (heads & (2 << (i << 3))) {
+				x = nvkm_rd32(device, 0x610b40 + (0x540 * i));
+				y = (x & 0xffff0000) >> 16;
+				x &= 0x0000ffff;
+				if ((x * y) > px) {
+					px = (x * y);
+					head_sync = i;
+				}
+			}
+		}
+	}
+
+	return head_sync;
+}
+
+/* Upload a script to the PMU, and have the MEMX process execute it.
+ *
+ * The head to synchronise to for VBLANK waits is determined here, rather
+ * than when the script was built, so previously built scripts remain
+ * valid across display configuration changes.
+ */
+static int
+memx_exec(struct nvkm_pmu *pmu, u32 base, const u32 *data, u32 words)
+{
+	struct nvkm_subdev *subdev = &pmu->subdev;
+	struct nvkm_device *device = subdev->device;
+	u32 finish, reply[2] = {};
+	u32 mthd, size, i, j;
+	int head = -2, ret;
+
+	/* acquire data segment access */
+	do {
+		nvkm_wr32(device, 0x10a580, 0x00000003);
+	} while (nvkm_rd32(device, 0x10a580) != 0x00000003);
+	nvkm_wr32(device, 0x10a1c0, 0x01000000 | base);
+
+	for (i = 0; i < words; i += size + 1) {
+		mthd = data[i] & 0x0000ffff;
+		size = data[i] >> 16;
+
+		if (mthd == MEMX_VBLANK) {
+			if (head == -2)
+				head = memx_vblank_head(pmu);
+			if (head < 0) {
+				nvkm_debug(subdev, "WAIT VBLANK !NO ACTIVE HEAD\n");
+				continue;
+			}
+			nvkm_debug(subdev, "WAIT VBLANK HEAD%d\n", head);
+			nvkm_wr32(device, 0x10a1c4, data[i]);
+			nvkm_wr32(device, 0x10a1c4, head);
+			continue;
+		}
+
+		for (j = 0; j <= size; j++)
+			nvkm_wr32(device, 0x10a1c4, data[i + j]);
+	}
+
+	/* release data segment access */
+	finish = nvkm_rd32(device, 0x10a1c0) & 0x00ffffff;
+	nvkm_wr32(device, 0x10a580, 0x00000000);
+
+	/* call MEMX process to execute the script, and wait for reply */
+	ret = nvkm_pmu_send(pmu, reply, PROC_MEMX, MEMX_MSG_EXEC,
+			    base, finish);
+
+	nvkm_debug(subdev, "Exec took %uns, PMU_IN %08x\n",
+		   reply[0], reply[1]);
+	return ret;
+}
+
 int
 nvkm_memx_init(struct nvkm_pmu *pmu, struct nvkm_memx **pmemx)
 {
-	struct nvkm_device *device = pmu->subdev.device;
 	struct nvkm_memx *memx;
 	u32 reply[2];
 	int ret;
@@ -59,11 +154,13 @@ nvkm_memx_init(struct nvkm_pmu *pmu, struct nvkm_memx **pmemx)
 	memx->base = reply[0];
 	memx->size = reply[1];
 
-	/* acquire data segment access */
-	do {
-		nvkm_wr32(device, 0x10a580, 0x00000003);
-	} while (nvkm_rd32(device, 0x10a580) != 0x00000003);
-	nvkm_wr32(device, 0x10a1c0, 0x01000000 | memx->base);
+	memx->data = kvmalloc(memx->size, GFP_KERNEL);
+	if (!memx->data) {
+		kfree(memx);
+		*pmemx = NULL;
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
@@ -72,34 +169,105 @@ nvkm_memx_fini(struct nvkm_memx **pmemx, bool exec)
 {
 	struct nvkm_memx *memx = *pmemx;
 	struct nvkm_pmu *pmu = memx->pmu;
-	struct nvkm_subdev *subdev = &pmu->subdev;
-	struct nvkm_device *device = subdev->device;
-	u32 finish, reply[2];
+	int ret = 0;
 
 	/* flush the cache... */
 	memx_out(memx);
 
-	/* release data segment access */
-	finish = nvkm_rd32(device, 0x10a1c0) & 0x00ffffff;
-	nvkm_wr32(device, 0x10a580, 0x00000000);
+	nvkm_debug(&pmu->subdev, "script %d words, %d/%d writes merged\n",
+		   memx->words, memx->merged, memx->wr32);
 
-	/* call MEMX process to execute the script, and wait for reply */
+	if (memx->overflow) {
+		nvkm_error(&pmu->subdev, "script exceeds %d bytes\n",
+			   memx->size);
+		ret = -ENOSPC;
+	} else
 	if (exec) {
-		nvkm_pmu_send(pmu, reply, PROC_MEMX, MEMX_MSG_EXEC,
-			      memx->base, finish);
+		ret = memx_exec(pmu, memx->base, memx->data, memx->words);
 	}
 
-	nvkm_debug(subdev, "Exec took %uns, PMU_IN %08x\n",
-		   reply[0], reply[1]);
+	kvfree(memx->data);
 	kfree(memx);
-	return 0;
+	*pmemx = NULL;
+	return ret;
+}
+
+/* Take a copy of the script built so far, to be executed again later
+ * with nvkm_memx_exec().
+ */
+struct nvkm_memx_script *
+nvkm_memx_script(struct nvkm_memx *memx)
+{
+	struct nvkm_memx_script *script;
+
+	memx_out(memx);
+	if (memx->overflow)
+		return NULL;
+
+	script = kvmalloc(sizeof(*script) + memx->words * 4, GFP_KERNEL);
+	if (script) {
+		script->words = memx->words;
+		memcpy(script->data, memx->data,
+		       memx->words * sizeof(script->data[0]));
+	}
+	return script;
+}
+
+int
+nvkm_memx_exec(struct nvkm_pmu *pmu, const struct nvkm_memx_script *script)
+{
+	u32 reply[2];
+	int ret;
+
+	ret = nvkm_pmu_send(pmu, reply, PROC_MEMX, MEMX_MSG_INFO,
+			    MEMX_INFO_DATA, 0);
+	if (ret)
+		return ret;
+
+	if (script->words > reply[1] / 4)
+		return -ENOSPC;
+
+	return memx_exec(pmu, reply[0], script->data, script->words);
 }
 
 void
-nvkm_memx_wr32(struct nvkm_memx *memx, u32 addr, u32 data)
+nvkm_memx_elided(struct nvkm_memx *memx, u32 *wr32, u32 *merged)
+{
+	*wr32 = memx->wr32;
+	*merged = memx->merged;
+}
+
+/* An elidable write that immediately follows another elidable write to
+ * the same register replaces its value, any other command in between
+ * acts as a barrier.  Other writes are always emitted as-is.
+ */
+static void
+memx_wr32(struct nvkm_memx *memx, u32 addr, u32 data, bool elide)
 {
 	nvkm_debug(&memx->pmu->subdev, "R[%06x] = %08x\n", addr, data);
+	memx->wr32++;
+
+	if (elide && memx->merge && memx->c.mthd == MEMX_WR32 &&
+	    memx->c.data[memx->c.size - 2] == addr) {
+		memx->c.data[memx->c.size - 1] = data;
+		memx->merged++;
+		return;
+	}
+
 	memx_cmd(memx, MEMX_WR32, 2, (u32[]){ addr, data });
+	memx->merge = elide;
+}
+
+void
+nvkm_memx_wr32(struct nvkm_memx *memx, u32 addr, u32 data)
+{
+	memx_wr32(memx, addr, data, false);
+}
+
+void
+nvkm_memx_wr32_elide(struct nvkm_memx *memx, u32 addr, u32 data)
+{
+	memx_wr32(memx, addr, data, true);
 }
 
 void
@@ -123,34 +291,8 @@ nvkm_memx_nsec(struct nvkm_memx *memx, u32 nsec)
 void
 nvkm_memx_wait_vblank(struct nvkm_memx *memx)
 {
-	struct nvkm_subdev *subdev = &memx->pmu->subdev;
-	struct nvkm_device *device = subdev->device;
-	u32 heads, x, y, px = 0;
-	int i, head_sync;
-
-	if (device->chipset < 0xd0) {
-		heads = nvkm_rd32(device, 0x610050);
-		for (i = 0; i < 2; i++) {
-			/* Heuristic: sync to head with biggest resolution */
-			if (heads & (2 << (i << 3))) {
-				x = nvkm_rd32(device, 0x610b40 + (0x540 * i));
-				y = (x & 0xffff0000) >> 16;
-				x &= 0x0000ffff;
-				if ((x * y) > px) {
-					px = (x * y);
-					head_sync = i;
-				}
-			}
-		}
-	}
-
-	if (px == 0) {
-		nvkm_debug(subdev, "WAIT VBLANK !NO ACTIVE HEAD\n");
-		return;
-	}
-
-	nvkm_debug(subdev, "WAIT VBLANK HEAD%d\n", head_sync);
-	memx_cmd(memx, MEMX_VBLANK, 1, (u32[]){ head_sync });
+	/* Head is selected when the script is executed. */
+	memx_cmd(memx, MEMX_VBLANK, 1, (u32[]){ 0 });
 	memx_out(memx); /* fuc can't handle multiple */
 }
 
@@ -216,6 +216,12 @@ list_del_init(struct list_head *entry)
     INIT_LIST_HEAD(entry);
 }
 
+static inline void list_move(struct list_head *list, struct list_head *head)
+{
+	__list_del(list->prev, list->next);
+	list_add(list, head);
+}
+
 static inline void list_move_tail(struct list_head *list,
 				  struct list_head *head)
 {
@@ -70,6 +70,7 @@ typedef dma_addr_t resource_size_t;
 #define max_t(t,a,b) max((t)(a), (t)(b))
 #define min_t(t,a,b) min((t)(a), (t)(b))
 #define clamp(a,b,c) min(max((a), (b)), (c))
+#define clamp_t(t,a,b,c) clamp((t)(a), (t)(b), (t)(c))
 #define roundup(a,b) ((((a) + ((b) - 1)) / (b)) * (b))
 #define round_up(a,b) roundup((a), (b))
 #define rounddown(a,b) ((a) / (b) * (b))
@@ -315,6 +316,17 @@ find_next_bit(const volatile unsigned long *addr, int bits, int bit)
 	return bit;
 }
 
+static inline long
+find_next_zero_bit(const volatile unsigned long *addr, int bits, int bit)
+{
+	while (bit < bits) {
+		if (!test_bit(bit, addr))
+			break;
+		bit++;
+	}
+	return bit;
+}
+
 static inline long
 find_first_zero_bit(volatile unsigned long *addr, int bits)
 {
@@ -334,6 +346,13 @@ bitmap_fill(unsigned long *addr, unsigned int bits)
 		__set_bit(bit, addr);
 }
 
+static inline void
+bitmap_set(unsigned long *addr, unsigned int pos, unsigned int bits)
+{
+	while (bits--)
+		__set_bit(pos++, addr);
+}
+
 static inline void
 bitmap_clear(unsigned long *addr, unsigned int pos, unsigned int bits)
 {
@@ -341,6 +360,26 @@ bitmap_clear(unsigned long *addr, unsigned int pos, unsigned int bits)
 		__clear_bit(pos++, addr);
 }
 
+static inline unsigned long
+bitmap_find_next_zero_area(unsigned long *map, unsigned long size,
+			   unsigned long start, unsigned int nr,
+			   unsigned long align_mask)
+{
+	unsigned long index, end, i;
+again:
+	index = find_next_zero_bit(map, size, start);
+	index = (index + align_mask) & ~align_mask;
+	end = index + nr;
+	if (end > size)
+		return end;
+	i = find_next_bit(map, end, index);
+	if (i < end) {
+		start = i + 1;
+		goto again;
+	}
+	return index;
+}
+
 #define for_each_set_bit(bit, addr, size)                                      \
 	for ((bit) = find_next_bit((addr), (size), 0); (bit) < (size);         \
 	     (bit) = find_next_bit((addr), (size), (bit) + 1))
@@ -378,6 +417,18 @@ atomic_inc_not_zero(atomic_t *a)
 	return v != 0;
 }
 
+#define READ_ONCE(a) (*(const volatile typeof(a) *)&(a))
+#define WRITE_ONCE(a,b) (*(volatile typeof(a) *)&(a) = (b))
+
+typedef struct atomic64 {
+	s64 value;
+} atomic64_t;
+
+#define atomic64_read(a) ((a)->value)
+#define atomic64_set(a,b) ((a)->value = (b))
+#define atomic64_inc(a) ((void) __sync_fetch_and_add (&(a)->value, 1))
+#define atomic64_add(b,a) ((void) __sync_add_and_fetch(&(a)->value, (b)))
+
 /******************************************************************************
  * refcount
  *****************************************************************************/
@@ -388,6 +439,7 @@ typedef struct refcount {
 #define refcount_set(a,b) atomic_set(&(a)->atomic, (b))
 #define refcount_inc(a) atomic_inc(&(a)->atomic)
 #define refcount_inc_not_zero(a) atomic_inc_not_zero(&(a)->atomic)
+#define refcount_read(a) atomic_read(&(a)->atomic)
 #define refcount_dec_and_test(a) atomic_dec_and_test(&(a)->atomic)
 #define refcount_dec_and_mutex_lock(a,b) ({                                    \
 	struct mutex *_m = (b);                                                \
@@ -496,6 +548,8 @@ kstrtoul(const char *s, unsigned int base, unsigned long *res)
 #define GFP_DMA32     4
 #define GFP_USER      8
 #define GFP_HIGHUSER 16
+#define __GFP_NORETRY 32
+#define __GFP_NOWARN  64
 
 typedef unsigned gfp_t;
 
@@ -508,8 +562,14 @@ typedef unsigned gfp_t;
 #define kvmalloc(a,b) kmalloc((a), (b))
 #define kvzalloc(a,b) kzalloc((a), (b))
 #define kvfree(a) kfree(a)
+#define kvmalloc_array(a,b,c) calloc((a), (b))
 
 #define vzalloc(a) calloc(1, (a))
+
+/******************************************************************************
+ * sort
+ *****************************************************************************/
+#define sort(b,n,s,c,w) qsort((b), (n), (s), (c))
 #define vfree free
 
 static inline void *
@@ -535,6 +595,30 @@ __free_page(struct page *page)
 {
 }
 
+static inline struct page *
+alloc_pages(gfp_t gfp, unsigned int order)
+{
+	return NULL;
+}
+
+static inline void
+__free_pages(struct page *page, unsigned int order)
+{
+}
+
+static inline void
+split_page(struct page *page, unsigned int order)
+{
+}
+
+#define nth_page(a,b) ((a) + (b))
+
+static inline int
+get_order(unsigned long size)
+{
+	return order_base_2((size + PAGE_SIZE - 1) >> PAGE_SHIFT);
+}
+
 static inline dma_addr_t
 page_to_phys(struct page *page)
 {
@@ -716,6 +800,58 @@ struct mutex {
 #define mutex_lock(a) pthread_mutex_lock(&(a)->mutex)
 #define mutex_unlock(a) pthread_mutex_unlock(&(a)->mutex)
 
+/******************************************************************************
+ * seqcount
+ *****************************************************************************/
+typedef struct seqcount {
+	unsigned sequence;
+} seqcount_t;
+
+#define seqcount_init(a) ((a)->sequence = 0)
+
+static inline unsigned
+raw_read_seqcount(const seqcount_t *s)
+{
+	return __atomic_load_n(&s->sequence, __ATOMIC_ACQUIRE);
+}
+
+static inline int
+read_seqcount_retry(const seqcount_t *s, unsigned start)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&s->sequence, __ATOMIC_RELAXED) != start;
+}
+
+static inline void
+write_seqcount_begin(seqcount_t *s)
+{
+	__atomic_store_n(&s->sequence, s->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+write_seqcount_end(seqcount_t *s)
+{
+	__atomic_store_n(&s->sequence, s->sequence + 1, __ATOMIC_RELEASE);
+}
+
+#define cpu_relax() __asm__ __volatile__("" ::: "memory")
+
+/******************************************************************************
+ * rcu
+ *****************************************************************************/
+struct rcu_head {
+	struct rcu_head *next;
+	void *ptr;
+};
+
+void rcu_read_lock(void);
+void rcu_read_unlock(void);
+void nvos_kfree_rcu(struct rcu_head *, void *);
+#define kfree_rcu(a,b) nvos_kfree_rcu(&(a)->b, (a))
+#define rcu_dereference(a) READ_ONCE(a)
+#define rcu_assign_pointer(a,b) WRITE_ONCE((a), (b))
+
 /******************************************************************************
  * lockdep
  *****************************************************************************/
@@ -751,6 +887,7 @@ struct rb_node {
 };
 
 #define rb_entry(a,b,c) container_of(a,b,c)
+#define rb_parent(a) ((a)->parent)
 
 #define RB_EMPTY_NODE(a) ((a)->parent == (a))
 #define RB_CLEAR_NODE(a) ((a)->parent = (a))
@@ -761,6 +898,17 @@ void rb_erase(struct rb_node *, struct rb_root *);
 struct rb_node *rb_first(struct rb_root *);
 struct rb_node *rb_next(struct rb_node *);
 
+struct rb_augment_callbacks {
+	void (*propagate)(struct rb_node *node, struct rb_node *stop);
+	void (*copy)(struct rb_node *old, struct rb_node *new);
+	void (*rotate)(struct rb_node *old, struct rb_node *new);
+};
+
+void rb_insert_augmented(struct rb_node *, struct rb_root *,
+			 const struct rb_augment_callbacks *);
+void rb_erase_augmented(struct rb_node *, struct rb_root *,
+			const struct rb_augment_callbacks *);
+
 /******************************************************************************
  * io space
  *****************************************************************************/
@@ -786,6 +934,24 @@ void  nvos_iounmap(void __iomem *ptr);
 #define memcpy_toio memcpy
 #define wmb()
 
+static inline void
+__ioread32_copy(void *to, const void *from, size_t count)
+{
+	u32 *dst = to;
+	const volatile u32 *src = from;
+	while (count--)
+		*dst++ = *src++;
+}
+
+static inline void
+__iowrite32_copy(void *to, const void *from, size_t count)
+{
+	volatile u32 *dst = to;
+	const u32 *src = from;
+	while (count--)
+		*dst++ = *src++;
+}
+
 static inline int
 arch_phys_wc_add(u64 base, u64 size)
 {
@@ -1273,6 +1439,11 @@ platform_get_irq_byname(struct platform_device *pdev, const char *name)
  * sg table
  *****************************************************************************/
 struct scatterlist {
+	struct page *page;
+	unsigned int offset;
+	unsigned int length;
+	dma_addr_t dma_address;
+	unsigned int dma_length;
 };
 
 struct sg_table {
@@ -1283,8 +1454,35 @@ struct sg_table {
 #define for_each_sg(sglist, sg, nr, __i)	                               \
 	for (__i = 0, sg = (sglist); __i < (nr); __i++, sg = sg_next(sg))
 #define sg_next(a) (a)
-#define sg_dma_address(a) 0ULL
-#define sg_dma_len(a) 0ULL
+#define sg_dma_address(a) ((a)->dma_address)
+#define sg_dma_len(a) ((a)->dma_length)
+#define sg_page(a) ((a)->page)
+
+static inline void
+sg_set_page(struct scatterlist *sg, struct page *page,
+	    unsigned int len, unsigned int offset)
+{
+	sg->page = page;
+	sg->offset = offset;
+	sg->length = len;
+}
+
+static inline int
+sg_alloc_table(struct sg_table *sgt, unsigned int nents, gfp_t gfp)
+{
+	if (!(sgt->sgl = calloc(nents, sizeof(*sgt->sgl))))
+		return -ENOMEM;
+	sgt->nents = nents;
+	return 0;
+}
+
+static inline void
+sg_free_table(struct sg_table *sgt)
+{
+	free(sgt->sgl);
+	sgt->sgl = NULL;
+	sgt->nents = 0;
+}
 
 /******************************************************************************
  * firmware
@@ -93,6 +93,36 @@ rb_erase(struct rb_node *node, struct rb_root *root)
 	}
 }
 
+void
+rb_insert_augmented(struct rb_node *node, struct rb_root *root,
+		    const struct rb_augment_callbacks *augment)
+{
+	/* no rotations, the caller has already updated the path down */
+}
+
+void
+rb_erase_augmented(struct rb_node *node, struct rb_root *root,
+		   const struct rb_augment_callbacks *augment)
+{
+	struct rb_node *fixup = node->parent;
+
+	/* determine the deepest node whose subtree is about to change */
+	if (node->rb_left && node->rb_right) {
+		struct rb_node *lr = node->rb_left;
+		while (lr->rb_right)
+			lr = lr->rb_right;
+		fixup = (node->rb_left != lr) ? lr->parent : lr;
+	}
+
+	rb_erase(node, root);
+
+	/* the erase can relink subtrees below other nodes on the path,
+	 * so recompute each node individually all the way to the root
+	 */
+	for (; fixup; fixup = fixup->parent)
+		augment->propagate(fixup, fixup->parent);
+}
+
 struct rb_node *
 rb_first(struct rb_root *root)
 {
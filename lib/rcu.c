@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 Red Hat Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "priv.h"
+
+/* Minimal two-epoch RCU.  Readers register with the current epoch, objects
+ * passed to kfree_rcu() are queued on it, and the epoch is flipped once
+ * nobody remains in the previous one.  Queued objects are freed once all
+ * readers of the epoch they were queued in have left, so they're never
+ * freed while a reader that may have seen them is still running.
+ */
+static pthread_mutex_t nvos_rcu_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct rcu_head *nvos_rcu_queue[2];
+static unsigned long nvos_rcu_readers[2];
+static int nvos_rcu_epoch;
+
+static __thread int nvos_rcu_depth;
+static __thread int nvos_rcu_reader;
+
+/* Returns a list of objects that are now safe to free. */
+static struct rcu_head *
+nvos_rcu_advance(void)
+{
+	struct rcu_head *done = NULL, *head;
+	int prev;
+
+	for (;;) {
+		prev = !nvos_rcu_epoch;
+		if (nvos_rcu_readers[prev])
+			break;
+
+		while ((head = nvos_rcu_queue[prev])) {
+			nvos_rcu_queue[prev] = head->next;
+			head->next = done;
+			done = head;
+		}
+
+		if (!nvos_rcu_queue[nvos_rcu_epoch])
+			break;
+		nvos_rcu_epoch = prev;
+	}
+
+	return done;
+}
+
+static void
+nvos_rcu_free(struct rcu_head *head)
+{
+	struct rcu_head *next;
+
+	for (; head; head = next) {
+		next = head->next;
+		kfree(head->ptr);
+	}
+}
+
+void
+rcu_read_lock(void)
+{
+	if (nvos_rcu_depth++)
+		return;
+
+	pthread_mutex_lock(&nvos_rcu_mutex);
+	nvos_rcu_reader = nvos_rcu_epoch;
+	nvos_rcu_readers[nvos_rcu_reader]++;
+	pthread_mutex_unlock(&nvos_rcu_mutex);
+}
+
+void
+rcu_read_unlock(void)
+{
+	struct rcu_head *done = NULL;
+
+	if (WARN_ON(!nvos_rcu_depth) || --nvos_rcu_depth)
+		return;
+
+	pthread_mutex_lock(&nvos_rcu_mutex);
+	if (!--nvos_rcu_readers[nvos_rcu_reader])
+		done = nvos_rcu_advance();
+	pthread_mutex_unlock(&nvos_rcu_mutex);
+	nvos_rcu_free(done);
+}
+
+void
+nvos_kfree_rcu(struct rcu_head *head, void *ptr)
+{
+	struct rcu_head *done;
+
+	pthread_mutex_lock(&nvos_rcu_mutex);
+	head->ptr = ptr;
+	head->next = nvos_rcu_queue[nvos_rcu_epoch];
+	nvos_rcu_queue[nvos_rcu_epoch] = head;
+	done = nvos_rcu_advance();
+	pthread_mutex_unlock(&nvos_rcu_mutex);
+	nvos_rcu_free(done);
+}